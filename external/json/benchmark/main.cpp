@@ -0,0 +1,376 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// NOTE: Every global allocation is counted, blocks are prefixed with their
+// size so the peak of live heap memory can be tracked.
+static size_t allocations = 0;
+static size_t live = 0;
+static size_t peak = 0;
+static const size_t header = 16;
+
+void *operator new(size_t size) {
+  char *block = static_cast<char *>(std::malloc(header + size));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t *>(block) = size;
+  allocations++;
+  live += size;
+  if (peak < live) {
+    peak = live;
+  }
+  return block + header;
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer) {
+    char *block = static_cast<char *>(pointer) - header;
+    live -= *reinterpret_cast<size_t *>(block);
+    std::free(block);
+  }
+}
+
+/// @brief Deterministic pseudo random numbers so corpora are reproducible.
+class generator {
+ public:
+  generator() : mState(0x2545f4914f6cdd1dull) {}
+
+  uint32_t next(uint32_t bound) {
+    mState = mState * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<uint32_t>(mState >> 33) % bound;
+  }
+
+ private:
+  uint64_t mState;
+};
+
+static const char *words[] = {
+    "update", "the",     "issue",   "tracker", "when", "a",     "release",
+    "is",     "created", "résumé",  "naïve",   "über", "fix",   "crash",
+    "in",     "parser",  "\"quote\"", "path/to", "tab\t", "more", "details"};
+
+/// @brief A sentence of count words, including escapes and UTF-8.
+std::string text(generator &random, size_t count) {
+  std::string text;
+  for (size_t index = 0; index < count; index++) {
+    if (index) {
+      text += 0 == random.next(12) ? "\n" : " ";
+    }
+    text += words[random.next(sizeof(words) / sizeof(words[0]))];
+  }
+  return text;
+}
+
+/// @brief A timestamp in the format used by Redmine.
+std::string timestamp(generator &random) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "20%02u-%02u-%02uT%02u:%02u:%02uZ",
+           10 + random.next(10), 1 + random.next(12), 1 + random.next(28),
+           random.next(24), random.next(60), random.next(60));
+  return buffer;
+}
+
+/// @brief A reference to another Redmine item.
+json::value reference(uint32_t id, std::string name) {
+  json::object object;
+  object.emplace("id", id);
+  object.emplace("name", std::move(name));
+  return json::value(std::move(object));
+}
+
+json::value issue(generator &random, uint32_t id) {
+  json::object issue;
+  issue.emplace("id", id);
+  issue.emplace("project", reference(1 + random.next(50), text(random, 2)));
+  issue.emplace("tracker", reference(1 + random.next(3), "Bug"));
+  issue.emplace("status", reference(1 + random.next(6), "New"));
+  issue.emplace("priority", reference(1 + random.next(5), "Normal"));
+  issue.emplace("author", reference(1 + random.next(200), text(random, 2)));
+  if (random.next(2)) {
+    issue.emplace("assigned_to",
+                  reference(1 + random.next(200), text(random, 2)));
+  }
+  issue.emplace("subject", text(random, 4 + random.next(8)));
+  issue.emplace("description", text(random, 20 + random.next(200)));
+  issue.emplace("start_date", timestamp(random).substr(0, 10));
+  issue.emplace("due_date");
+  issue.emplace("done_ratio", random.next(11) * 10);
+  issue.emplace("is_private", false);
+  if (random.next(2)) {
+    issue.emplace("estimated_hours", random.next(400) / 4.0);
+  } else {
+    issue.emplace("estimated_hours");
+  }
+  json::array fields;
+  for (uint32_t field = 1; field <= 3; field++) {
+    json::object custom;
+    custom.emplace("id", field);
+    custom.emplace("name", text(random, 2));
+    custom.emplace("value", text(random, 1));
+    fields.emplace(std::move(custom));
+  }
+  issue.emplace("custom_fields", std::move(fields));
+  issue.emplace("created_on", timestamp(random));
+  issue.emplace("updated_on", timestamp(random));
+  issue.emplace("closed_on");
+  return json::value(std::move(issue));
+}
+
+/// @brief The body of a page of /issues.json.
+json::value issues(size_t count) {
+  generator random;
+  json::array issues;
+  issues.reserve(count);
+  for (size_t index = 0; index < count; index++) {
+    issues.append(issue(random, static_cast<uint32_t>(index + 1)));
+  }
+  json::object root;
+  root.emplace("issues", std::move(issues));
+  root.emplace("total_count", static_cast<uint64_t>(count));
+  root.emplace("offset", 0);
+  root.emplace("limit", static_cast<uint64_t>(count));
+  return json::value(std::move(root));
+}
+
+/// @brief The body of /projects.json.
+json::value projects(size_t count) {
+  generator random;
+  json::array projects;
+  projects.reserve(count);
+  for (size_t index = 0; index < count; index++) {
+    const uint32_t id = static_cast<uint32_t>(index + 1);
+    json::object project;
+    project.emplace("id", id);
+    project.emplace("name", text(random, 3));
+    project.emplace("identifier", "project-" + std::to_string(id));
+    project.emplace("description", text(random, 10 + random.next(60)));
+    project.emplace("homepage", "https://example.com/" + std::to_string(id));
+    if (1 < id && random.next(2)) {
+      project.emplace("parent", reference(random.next(id - 1) + 1,
+                                          text(random, 3)));
+    }
+    project.emplace("status", 1);
+    project.emplace("is_public", 0 != random.next(4));
+    project.emplace("inherit_members", false);
+    project.emplace("created_on", timestamp(random));
+    project.emplace("updated_on", timestamp(random));
+    projects.append(std::move(project));
+  }
+  json::object root;
+  root.emplace("projects", std::move(projects));
+  root.emplace("total_count", static_cast<uint64_t>(count));
+  root.emplace("offset", 0);
+  root.emplace("limit", static_cast<uint64_t>(count));
+  return json::value(std::move(root));
+}
+
+/// @brief The body of /users/current.json with count memberships.
+json::value current_user(size_t count) {
+  generator random;
+  json::array memberships;
+  memberships.reserve(count);
+  for (size_t index = 0; index < count; index++) {
+    json::array roles;
+    for (uint32_t role = 0, roles_count = 1 + random.next(3);
+         role < roles_count; role++) {
+      roles.append(reference(3 + random.next(5), text(random, 1)));
+    }
+    json::object membership;
+    membership.emplace("id", static_cast<uint32_t>(index + 1));
+    membership.emplace("project", reference(static_cast<uint32_t>(index + 1),
+                                            text(random, 3)));
+    membership.emplace("roles", std::move(roles));
+    memberships.append(std::move(membership));
+  }
+  json::array groups;
+  for (uint32_t group = 1; group <= 4; group++) {
+    groups.append(reference(group, text(random, 2)));
+  }
+  json::object user;
+  user.emplace("id", 1);
+  user.emplace("login", "jsmith");
+  user.emplace("admin", false);
+  user.emplace("firstname", "John");
+  user.emplace("lastname", "Smith");
+  user.emplace("mail", "jsmith@example.com");
+  user.emplace("created_on", timestamp(random));
+  user.emplace("last_login_on", timestamp(random));
+  user.emplace("api_key", "3f4a5b6c7d8e9f0a1b2c3d4e5f6a7b8c9d0e1f2a");
+  user.emplace("memberships", std::move(memberships));
+  user.emplace("groups", std::move(groups));
+  return json::value(json::object("user", std::move(user)));
+}
+
+/// @brief The body of /issues/<id>.json?include=journals with count
+/// journals.
+json::value journals(size_t count) {
+  generator random;
+  json::array journals;
+  journals.reserve(count);
+  for (size_t index = 0; index < count; index++) {
+    json::array details;
+    for (uint32_t detail = 0, details_count = random.next(3);
+         detail < details_count; detail++) {
+      json::object change;
+      change.emplace("property", "attr");
+      change.emplace("name", "status_id");
+      change.emplace("old_value", std::to_string(1 + random.next(6)));
+      change.emplace("new_value", std::to_string(1 + random.next(6)));
+      details.append(std::move(change));
+    }
+    json::object journal;
+    journal.emplace("id", static_cast<uint32_t>(index + 1));
+    journal.emplace("user", reference(1 + random.next(200), text(random, 2)));
+    journal.emplace("notes", text(random, random.next(4) ? 5 + random.next(80)
+                                                         : 0));
+    journal.emplace("created_on", timestamp(random));
+    journal.emplace("private_notes", false);
+    journal.emplace("details", std::move(details));
+    journals.append(std::move(journal));
+  }
+  json::value root = issue(random, 1);
+  root.object().emplace("journals", std::move(journals));
+  return json::value(json::object("issue", std::move(root)));
+}
+
+struct measurement {
+  double seconds;
+  size_t allocations;
+  size_t peak;
+};
+
+/// @brief Run an operation until enough time has passed to be stable.
+///
+/// @return Returns the fastest run and the allocations and peak heap memory
+/// of a single run.
+measurement measure(const std::function<void()> &operation) {
+  typedef std::chrono::steady_clock clock;
+  measurement result = {0, 0, 0};
+  double total = 0;
+  for (size_t run = 0; run < 50 && total < 0.5; run++) {
+    const size_t before = allocations;
+    peak = live;
+    const size_t base = live;
+    const clock::time_point start = clock::now();
+    operation();
+    const double seconds =
+        std::chrono::duration<double>(clock::now() - start).count();
+    total += seconds;
+    if (!run || seconds < result.seconds) {
+      result.seconds = seconds;
+    }
+    result.allocations = allocations - before;
+    result.peak = peak - base;
+  }
+  return result;
+}
+
+void report(const char *corpus, size_t records, const char *operation,
+            size_t bytes, const measurement &measurement) {
+  printf("%-14s %7zu  %-13s %9.1f %11zu %11zu\n", corpus, records, operation,
+         bytes / measurement.seconds / (1024 * 1024), measurement.allocations,
+         measurement.peak / 1024);
+}
+
+/// @brief Receives every event and ignores it.
+struct handler : public json::handler {};
+
+void benchmark(const char *corpus, size_t records, const json::value &value) {
+  const std::string source = json::write(value, json::compact);
+  const size_t size = source.size();
+  // NOTE: Read in chunks as they arrive from the network.
+  const size_t chunk = 16 * 1024;
+
+  report(corpus, records, "value", size, measure([&] {
+    json::value value = json::read(source);
+  }));
+  report(corpus, records, "document", size, measure([&] {
+    json::document document;
+    json::read(source, document);
+  }));
+  report(corpus, records, "parser", size, measure([&] {
+    json::parser parser;
+    for (size_t offset = 0; offset < size; offset += chunk) {
+      parser.feed(source.data() + offset, std::min(chunk, size - offset));
+    }
+    parser.finish();
+  }));
+  report(corpus, records, "handler", size, measure([&] {
+    handler handler;
+    json::read(source, handler);
+  }));
+  report(corpus, records, "tape", size, measure([&] {
+    json::tape tape;
+    json::read(source, tape);
+  }));
+  report(corpus, records, "write", size, measure([&] {
+    std::string buffer;
+    json::write(value, buffer, json::compact);
+  }));
+  const size_t pretty = json::write(value, "  ").size();
+  report(corpus, records, "write pretty", pretty, measure([&] {
+    std::string buffer;
+    json::write(value, buffer, "  ");
+  }));
+}
+
+int main(int argc, char **argv) {
+  // NOTE: Larger corpora can be skipped by passing the largest record count.
+  const size_t limit = 1 < argc ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+  printf("%-14s %7s  %-13s %9s %11s %11s\n", "corpus", "records", "operation",
+         "MB/s", "allocations", "peak KiB");
+  for (size_t records : {1000, 10000, 100000}) {
+    if (limit < records) {
+      break;
+    }
+    benchmark("issues", records, issues(records));
+    benchmark("projects", records, projects(records));
+    benchmark("current_user", records, current_user(records));
+    benchmark("journals", records, journals(records));
+  }
+
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (0 == getrusage(RUSAGE_SELF, &usage)) {
+    // NOTE: Kilobytes on Linux, bytes on macOS.
+#if defined(__APPLE__)
+    usage.ru_maxrss /= 1024;
+#endif
+    printf("peak RSS: %ld KiB\n", static_cast<long>(usage.ru_maxrss));
+  }
+#endif
+
+  return 0;
+}
@@ -21,9 +21,14 @@
 #ifndef JSON_HPP
 #define JSON_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
 #include <map>
-#include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <type_traits>
 #include <vector>
 
@@ -40,52 +45,192 @@ enum type {
 
 // Forward declarations
 class value;
-typedef std::pair<const std::string, json::value> pair;
+class document;
+class handler;
+class node;
+class tape;
+typedef std::pair<std::string, json::value> pair;
 
 // API
 json::value read(const std::string &string, bool diag_on = true);
+json::value &read(const std::string &string, json::document &document,
+                  bool diag_on = true);
+bool read(const std::string &string, json::handler &handler,
+          bool diag_on = true);
+bool read(std::string string, json::tape &tape, bool diag_on = true);
+// NOTE: The file is mapped into memory and read in place, diagnostics are
+// prefixed by its path.
+json::value read_file(const std::string &path, bool diag_on = true);
+bool read_file(const std::string &path, json::handler &handler,
+               bool diag_on = true);
 std::string write(const json::value &value, const char *tab = "\t");
+void write(const json::value &value, std::string &buffer,
+           const char *tab = "\t");
+bool write(const json::value &value, FILE *file, const char *tab = "\t");
+
+// NOTE: Pass as the tab to write without any whitespace.
+const char *const compact = nullptr;
+
+// Memory
+class arena {
+ public:
+  // Constructors
+  arena(size_t block_size = 64 * 1024);
+  ~arena();
+
+  // Operations
+  void *allocate(size_t size, size_t alignment);
+  // NOTE: Freed memory is reused by later allocations of the same size class.
+  void deallocate(void *pointer, size_t size);
+  // NOTE: Destroy is called with the object once the arena is released,
+  // before its memory is.
+  void own(void *object, void (*destroy)(void *));
+  void release();
+
+ private:
+  arena(const arena &) = delete;
+  arena &operator=(const arena &) = delete;
+
+  struct block {
+    block *next;
+  };
+  struct free_block {
+    free_block *next;
+  };
+  struct cleanup {
+    cleanup *next;
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  // NOTE: One size class for each power of two.
+  static const size_t size_classes = 64;
+
+  block *mHead;
+  char *mCurrent;
+  char *mEnd;
+  size_t mBlockSize;
+  // NOTE: Freed memory of each size class, holding at least its power of two.
+  free_block *mFree[size_classes];
+  cleanup *mCleanups;
+};
+
+template <typename Type>
+class allocator {
+ public:
+  // Types
+  typedef Type value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  // Constructors
+  allocator();
+  allocator(json::arena *arena);
+  template <typename Other>
+  allocator(const json::allocator<Other> &other);
+
+  // Operations
+  Type *allocate(size_t count);
+  void deallocate(Type *pointer, size_t count);
+  json::allocator<Type> select_on_container_copy_construction() const;
+
+  // NOTE: Null when allocating from the global heap.
+  json::arena *arena;
+};
+
+template <typename Type, typename Other>
+bool operator==(const json::allocator<Type> &lhs,
+                const json::allocator<Other> &rhs);
+template <typename Type, typename Other>
+bool operator!=(const json::allocator<Type> &lhs,
+                const json::allocator<Other> &rhs);
+
+// Strings
+class view {
+ public:
+  // Constructors
+  view();
+  view(const char *data, size_t size);
+  view(const std::string &string);
+
+  // Accessors
+  const char *data() const;
+  size_t size() const;
+  std::string str() const;
+
+ private:
+  const char *mData;
+  size_t mSize;
+};
+
+bool operator==(const json::view &lhs, const json::view &rhs);
+bool operator!=(const json::view &lhs, const json::view &rhs);
 
 // Objects
 class object {
  public:
   // Types
-  typedef std::map<std::string, json::value>::iterator iterator;
-  typedef std::map<std::string, json::value>::const_iterator const_iterator;
+  // NOTE: Entries are kept in insertion order.
+  typedef std::vector<json::pair, json::allocator<json::pair>> vector;
+  typedef vector::iterator iterator;
+  typedef vector::const_iterator const_iterator;
 
   // Constructors
   object();
+  explicit object(json::arena *arena);
   object(std::string key, json::value value);
   object(json::pair pair);
   template <typename Type>
-  object(std::string key, Type value);
+  object(std::string key, Type &&value);
   object(std::initializer_list<json::pair> values);
 
   // Accessors
+  // NOTE: An existing entry with the same key is replaced.
   void add(std::string key, json::value value);
   template <typename Type>
-  void add(std::string key, Type value);
+  void add(std::string key, Type &&value);
   void add(json::pair pair);
+  template <typename... Args>
+  json::value &emplace(std::string key, Args &&... args);
 
-  json::value *get(std::string key);
-  const json::value *get(std::string key) const;
+  json::value *get(const char *key);
+  const json::value *get(const char *key) const;
+  json::value *get(const json::view &key);
+  const json::value *get(const json::view &key) const;
 
   iterator begin();
   const_iterator begin() const;
   iterator end();
   const_iterator end() const;
 
+  size_t size() const;
+  void reserve(size_t count);
+
  private:
-  std::map<std::string, json::value> mEntries;
+  // NOTE: Objects with more entries than this are indexed.
+  static const size_t index_threshold = 16;
+
+  friend class value;
+
+  json::value &insert(std::string key, json::value value);
+  size_t find(const json::view &key) const;
+  void reindex();
+
+  vector mEntries;
+  // NOTE: Open addressing table of entry positions plus one, zero is empty.
+  std::vector<uint32_t, json::allocator<uint32_t>> mIndex;
 };
 
 class array {
  public:
   // Types
-  typedef std::vector<json::value>::iterator iterator;
-  typedef std::vector<json::value>::const_iterator const_iterator;
+  typedef std::vector<json::value, json::allocator<json::value>> vector;
+  typedef vector::iterator iterator;
+  typedef vector::const_iterator const_iterator;
 
   // Constructors
+  explicit array(json::arena *arena);
   array(std::initializer_list<json::value> values);
   template <typename... Args>
   array(Args... args);
@@ -93,7 +238,9 @@ class array {
   // Accessors
   void append(json::value value);
   template <typename Type>
-  void append(Type value);
+  void append(Type &&value);
+  template <typename... Args>
+  json::value &emplace(Args &&... args);
   iterator begin();
   const_iterator begin() const;
   iterator end();
@@ -105,9 +252,12 @@ class array {
 
   size_t size();
   size_t size() const;
+  void reserve(size_t count);
 
  private:
-  std::vector<json::value> mEntries;
+  friend class value;
+
+  vector mEntries;
 };
 
 class value {
@@ -115,8 +265,10 @@ class value {
   // Constructors
   value();  // NOTE: A null value
   value(json::object object);
+  value(json::object object, json::arena *arena);
   value(json::pair pair);
   value(json::array array);
+  value(json::array array, json::arena *arena);
   explicit value(int8_t number);
   explicit value(int16_t number);
   explicit value(int32_t number);
@@ -129,7 +281,15 @@ class value {
   explicit value(double number);
   value(const char *string);
   value(std::string string);
+  value(std::string string, json::arena *arena);
+  value(json::view string, json::arena *arena);
   explicit value(bool boolean);
+  value(const json::value &other);
+  value(json::value &&other) noexcept;
+  ~value();
+
+  // Operators
+  json::value &operator=(json::value other);
 
   // Accessors
   json::type &type();
@@ -138,83 +298,493 @@ class value {
   const json::object &object() const;
   json::array &array();
   const json::array &array() const;
+  // NOTE: The reference may be assigned through so an integer is converted
+  // to a double, use number<Type>() to read an integer exactly.
   double &number();
-  const double &number() const;
+  double number() const;
   template <typename Number>
   Number number();
   template <typename Number>
   Number number() const;
+  bool integer() const;
   std::string &string();
   const std::string &string() const;
+  json::view view() const;
   bool &boolean();
   const bool &boolean() const;
 
+  // Operations
+  void swap(json::value &other);
+
  private:
-  struct store_base {
-    virtual ~store_base() {}
+  // NOTE: Scalars are stored inline, strings, objects and arrays are owned by
+  // the value and deep copied along with it. Payloads allocated from an arena
+  // are released with the arena. The characters of a string in an arena are
+  // retained by it, its payload holds a view until string() constructs a
+  // std::string in place which the arena then destroys. Objects and arrays in
+  // an arena are only destroyed when they may hold memory outside of it,
+  // which the non-const accessors allow adding.
+  union storage {
+    double number;
+    int64_t integer;
+    uint64_t unsigned_integer;
+    bool boolean;
+    std::string *string;
+    json::object *object;
+    json::array *array;
+  };
+
+  // NOTE: The payload of a string in an arena until it is materialized.
+  struct arena_view {
+    json::view string;
+    json::arena *arena;
   };
 
   template <typename Type>
-  struct store : public store_base {
-    store(Type value) : value(value) {}
-    Type value;
+  static Type *construct(Type &&payload, json::arena *arena);
+  template <typename Type>
+  void destroy(Type *payload);
+  void retain(const json::view &string, json::arena *arena);
+  void materialize() const;
+  static void destroy_string(void *string);
+  // NOTE: Whether destroying the value releases memory outside an arena.
+  bool owning() const;
+  static bool owning(const json::object &object, const json::arena *arena);
+  static bool owning(const json::array &array, const json::arena *arena);
+
+  // NOTE: Integer literals are stored exactly, other numbers as a double.
+  enum number_kind : unsigned char {
+    NUMBER_REAL,
+    NUMBER_SIGNED,
+    NUMBER_UNSIGNED,
+  };
+
+  json::type mType;
+  // NOTE: Mutable as a view is materialized by const accessors.
+  mutable bool mArena;
+  mutable bool mView;
+  // NOTE: Whether an object or array in an arena may hold memory outside it.
+  bool mOwning;
+  number_kind mNumber;
+  mutable storage mStorage;
+};
+
+// Event handler
+class handler {
+ public:
+  virtual ~handler();
+
+  // Events
+  // NOTE: Return false to stop reading. Strings may be moved from, the
+  // default implementations ignore the event.
+  virtual bool begin_object();
+  virtual bool key(std::string &key);
+  virtual bool end_object();
+  virtual bool begin_array();
+  virtual bool end_array();
+  virtual bool string(std::string &string);
+  // NOTE: A string without escapes whose characters are retained by the
+  // arena of the parser. The default implementation copies the characters.
+  virtual bool string(const json::view &string);
+  virtual bool number(double number);
+  // NOTE: Integer literals which fit in 64 bits. The default implementations
+  // convert to double.
+  virtual bool number(int64_t number);
+  virtual bool number(uint64_t number);
+  virtual bool boolean(bool boolean);
+  virtual bool null();
+};
+
+// Incremental reader
+class parser {
+ public:
+  // Constructors
+  parser();
+  explicit parser(json::arena *arena);
+  explicit parser(json::handler &handler);
+
+  // Operations
+  bool feed(const char *data, size_t size);
+  bool feed(const std::string &string);
+  bool finish();
+  void reset();
+
+  // Accessors
+  // NOTE: Null when events are sent to a handler.
+  json::value &value();
+  const json::value &value() const;
+  const char *error() const;
+  size_t line() const;
+  size_t column() const;
+
+ private:
+  parser(const parser &) = delete;
+  parser &operator=(const parser &) = delete;
+
+  enum state {
+    STATE_VALUE,
+    STATE_OBJECT_KEY_OR_END,
+    STATE_OBJECT_KEY,
+    STATE_OBJECT_COLON,
+    STATE_OBJECT_COMMA_OR_END,
+    STATE_ARRAY_VALUE_OR_END,
+    STATE_ARRAY_COMMA_OR_END,
+    STATE_STRING,
+    STATE_STRING_ESCAPE,
+    STATE_STRING_UNICODE,
+    STATE_NUMBER,
+    STATE_LITERAL,
+    STATE_DONE,
+    STATE_ERROR
+  };
+
+  // Builds a value from the events of the parser
+  class builder : public json::handler {
+   public:
+    explicit builder(json::arena *arena);
+
+    bool begin_object() override;
+    bool key(std::string &key) override;
+    bool end_object() override;
+    bool begin_array() override;
+    bool end_array() override;
+    bool string(std::string &string) override;
+    bool string(const json::view &string) override;
+    bool number(double number) override;
+    bool number(int64_t number) override;
+    bool number(uint64_t number) override;
+    bool boolean(bool boolean) override;
+    bool null() override;
+
+    void reset();
+
+    json::value value;
+
+   private:
+    struct frame {
+      json::type type;
+      json::object object;
+      json::array array;
+      std::string key;
+    };
+
+    bool complete(json::value value);
+    bool close();
+
+    json::arena *mArena;
+    std::vector<frame> mStack;
+  };
+
+  bool consume(const char c);
+  bool skips_whitespace() const;
+  bool fail(const char *error);
+  bool emit(bool accepted);
+  bool open(json::type type, bool accepted);
+  bool close(bool accepted);
+  bool complete_string();
+  bool complete_number();
+  bool complete_literal();
+
+  builder mBuilder;
+  json::handler *mHandler;
+  // NOTE: When not null, strings without escapes which are not split between
+  // chunks are copied to it and viewed, other data is never retained.
+  json::arena *mArena;
+  state mState;
+  // NOTE: Type of each open object or array.
+  std::vector<json::type> mStack;
+  std::string mToken;
+  std::string mHex;
+  const char *mLiteral;
+  bool mKey;
+  const char *mError;
+  size_t mLine;
+  size_t mColumn;
+  // NOTE: Continuation bytes of a UTF-8 sequence split by the end of the data
+  // and the valid range of the next one.
+  size_t mRemaining;
+  unsigned char mLow;
+  unsigned char mHigh;
+};
+
+// Writes the events of a reader as they arrive, in constant memory
+class writer : public json::handler {
+ public:
+  // Constructors
+  explicit writer(FILE *file, const char *tab = "\t");
+  ~writer();
+
+  // Events
+  bool begin_object() override;
+  bool key(std::string &key) override;
+  bool end_object() override;
+  bool begin_array() override;
+  bool end_array() override;
+  bool string(std::string &string) override;
+  bool string(const json::view &string) override;
+  bool number(double number) override;
+  bool number(int64_t number) override;
+  bool number(uint64_t number) override;
+  bool boolean(bool boolean) override;
+  bool null() override;
+
+  // Operations
+  // NOTE: Returns false when writing to the file failed.
+  bool flush();
+
+ private:
+  writer(const writer &) = delete;
+  writer &operator=(const writer &) = delete;
+
+  bool write(const json::value &value);
+  void separate();
+
+  std::string mBuffer;
+  FILE *mFile;
+  const char *mTab;
+  // NOTE: Whether each open object or array has no entries yet.
+  std::vector<bool> mEmpty;
+  bool mKey;
+  bool mFailed;
+};
+
+// A parsed JSON document whose values are allocated from an arena
+class document {
+ public:
+  // Constructors
+  document();
+
+  // Accessors
+  json::value &root();
+  const json::value &root() const;
+  json::arena &arena();
+
+ private:
+  document(const document &) = delete;
+  document &operator=(const document &) = delete;
+
+  // NOTE: Declared first so the root is destroyed before its memory.
+  json::arena mArena;
+  json::value mRoot;
+};
+
+// A value recorded on a tape, scalars are read from the source when accessed
+class node {
+ public:
+  // Types
+  // NOTE: Visits the elements of an array or the keys of an object, the
+  // value of the current key is given by value().
+  class iterator {
+   public:
+    iterator(const json::node *node, bool object);
+
+    const json::node &operator*() const;
+    const json::node *operator->() const;
+    const json::node &value() const;
+    iterator &operator++();
+    bool operator==(const iterator &other) const;
+    bool operator!=(const iterator &other) const;
+
+   private:
+    const json::node *mNode;
+    bool mObject;
   };
+  typedef iterator const_iterator;
+
+  // Accessors
+  json::type type() const;
+  // NOTE: Objects and arrays are navigated through the node itself.
+  const json::node &object() const;
+  const json::node &array() const;
+  const json::node *get(const char *key) const;
+  const json::node *get(const json::view &key) const;
+  iterator begin() const;
+  iterator end() const;
+  // NOTE: Entries of an object or elements of an array.
+  size_t size() const;
+  double number() const;
+  template <typename Number>
+  Number number() const;
+  bool integer() const;
+  // NOTE: Decodes escape sequences, prints an error and returns an empty
+  // string if they can not be decoded.
+  std::string string() const;
+  // NOTE: Characters of a string as they appear in the source, escape
+  // sequences are not decoded.
+  json::view view() const;
+  bool escaped() const;
+  bool boolean() const;
+
+  // Operations
+  // NOTE: Reads the node and everything it contains into a json::value.
+  json::value value() const;
+
+ private:
+  friend class tape;
+  friend bool read(std::string string, json::tape &tape, bool diag_on);
 
+  node(json::type type, const char *data, size_t size);
+
+  const json::node *next() const;
+
+  // NOTE: Characters of a scalar in the source, the opening brace or bracket
+  // of an object or array.
+  const char *mData;
+  // NOTE: Length of a scalar, number of entries of an object or array.
+  uint32_t mSize;
+  // NOTE: Number of nodes following this one which it contains, the keys and
+  // values of an object are recorded alternately.
+  uint32_t mSkip;
   json::type mType;
-  std::shared_ptr<store_base> mStore;
+  bool mEscaped;
+};
+
+// A JSON document recorded as a tape of nodes in one structural pass
+class tape {
+ public:
+  // Constructors
+  tape();
+
+  // Accessors
+  const json::node &root() const;
+
+ private:
+  tape(const tape &) = delete;
+  tape &operator=(const tape &) = delete;
+
+  friend bool read(std::string string, json::tape &tape, bool diag_on);
+
+  const char *record(const char *begin, const char *end, const char *&error);
+  const char *record_string(const char *begin, const char *end,
+                            const char *&error);
+  const char *record_number(const char *begin, const char *end,
+                            const char *&error);
+  const char *record_literal(const char *begin, const char *end,
+                             const char *literal, json::type type,
+                             const char *&error);
+
+  // NOTE: Nodes point into the source which is never modified.
+  std::string mSource;
+  std::vector<json::node> mNodes;
 };
 
 // Implementations
+template <typename Type>
+inline allocator<Type>::allocator()
+    : arena(nullptr) {}
+template <typename Type>
+inline allocator<Type>::allocator(json::arena *arena)
+    : arena(arena) {}
+template <typename Type>
+template <typename Other>
+inline allocator<Type>::allocator(const json::allocator<Other> &other)
+    : arena(other.arena) {}
+template <typename Type>
+inline Type *allocator<Type>::allocate(size_t count) {
+  if (arena) {
+    return static_cast<Type *>(
+        arena->allocate(count * sizeof(Type), alignof(Type)));
+  }
+  return static_cast<Type *>(::operator new(count * sizeof(Type)));
+}
+template <typename Type>
+inline void allocator<Type>::deallocate(Type *pointer, size_t count) {
+  if (arena) {
+    arena->deallocate(pointer, count * sizeof(Type));
+  } else {
+    ::operator delete(pointer);
+  }
+}
+template <typename Type>
+inline json::allocator<Type>
+allocator<Type>::select_on_container_copy_construction() const {
+  // NOTE: Copies are independent of the arena they were copied from.
+  return {};
+}
+template <typename Type, typename Other>
+inline bool operator==(const json::allocator<Type> &lhs,
+                       const json::allocator<Other> &rhs) {
+  return lhs.arena == rhs.arena;
+}
+template <typename Type, typename Other>
+inline bool operator!=(const json::allocator<Type> &lhs,
+                       const json::allocator<Other> &rhs) {
+  return lhs.arena != rhs.arena;
+}
+
 inline object::object() {}
+inline object::object(json::arena *arena)
+    : mEntries(json::allocator<json::pair>(arena)),
+      mIndex(json::allocator<uint32_t>(arena)) {}
 inline object::object(std::string key, json::value value) {
-  mEntries[key] = value;
+  add(std::move(key), std::move(value));
 }
-inline object::object(json::pair pair) { mEntries.insert(pair); }
+inline object::object(json::pair pair) { add(std::move(pair)); }
 template <typename Type>
-inline object::object(std::string key, Type value) {
-  mEntries[key] = value;
+inline object::object(std::string key, Type &&value) {
+  insert(std::move(key), json::value(std::forward<Type>(value)));
 }
 inline object::object(std::initializer_list<json::pair> pairs) {
-  mEntries.insert(pairs);
+  reserve(pairs.size());
+  for (auto &pair : pairs) {
+    add(pair);
+  }
 }
 
 inline void object::add(std::string key, json::value value) {
-  mEntries[key] = value;
+  insert(std::move(key), std::move(value));
 }
 template <typename Type>
-inline void object::add(std::string key, Type value) {
-  mEntries[key] = json::value(value);
-}
-inline void object::add(json::pair pair) { mEntries.insert(pair); }
-inline json::value *object::get(std::string key) {
-  auto iter = mEntries.find(key);
-  if (mEntries.end() == iter) {
-    return nullptr;
-  }
-  return &iter->second;
+inline void object::add(std::string key, Type &&value) {
+  insert(std::move(key), json::value(std::forward<Type>(value)));
 }
-inline const json::value *object::get(std::string key) const {
-  auto iter = mEntries.find(key);
-  if (mEntries.end() == iter) {
-    return nullptr;
-  }
-  return &iter->second;
+inline void object::add(json::pair pair) {
+  insert(std::move(pair.first), std::move(pair.second));
+}
+template <typename... Args>
+inline json::value &object::emplace(std::string key, Args &&... args) {
+  return insert(std::move(key), json::value(std::forward<Args>(args)...));
+}
+inline json::value *object::get(const char *key) {
+  return get(json::view(key, std::char_traits<char>::length(key)));
+}
+inline const json::value *object::get(const char *key) const {
+  return get(json::view(key, std::char_traits<char>::length(key)));
+}
+inline json::value *object::get(const json::view &key) {
+  const size_t index = find(key);
+  return mEntries.size() == index ? nullptr : &mEntries[index].second;
+}
+inline const json::value *object::get(const json::view &key) const {
+  const size_t index = find(key);
+  return mEntries.size() == index ? nullptr : &mEntries[index].second;
 }
 inline object::iterator object::begin() { return mEntries.begin(); }
 inline object::const_iterator object::begin() const { return mEntries.begin(); }
 inline object::iterator object::end() { return mEntries.end(); }
 inline object::const_iterator object::end() const { return mEntries.end(); }
+inline size_t object::size() const { return mEntries.size(); }
+inline void object::reserve(size_t count) { mEntries.reserve(count); }
 
+inline array::array(json::arena *arena)
+    : mEntries(json::allocator<json::value>(arena)) {}
 inline array::array(std::initializer_list<json::value> values)
     : mEntries(values) {}
 template <typename... Args>
 inline array::array(Args... args)
-    : mEntries(args...) {}
+    : mEntries(std::move(args)...) {}
 
-inline void array::append(json::value value) { mEntries.push_back(value); }
+inline void array::append(json::value value) {
+  mEntries.push_back(std::move(value));
+}
 template <typename Type>
-inline void array::append(Type value) {
-  mEntries.push_back(json::value(value));
+inline void array::append(Type &&value) {
+  mEntries.emplace_back(std::forward<Type>(value));
+}
+template <typename... Args>
+inline json::value &array::emplace(Args &&... args) {
+  mEntries.emplace_back(std::forward<Args>(args)...);
+  return mEntries.back();
 }
 inline array::iterator array::begin() { return mEntries.begin(); }
 inline array::const_iterator array::begin() const { return mEntries.begin(); }
@@ -232,68 +802,459 @@ inline const json::value &array::at(const size_t index) const {
 }
 inline size_t array::size() { return mEntries.size(); }
 inline size_t array::size() const { return mEntries.size(); }
+inline void array::reserve(size_t count) { mEntries.reserve(count); }
 
-inline value::value() : mType(TYPE_NULL), mStore(nullptr) {}
+inline value::value()
+    : mType(TYPE_NULL),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.number = 0;
+}
 inline value::value(json::object object)
     : mType(TYPE_OBJECT),
-      mStore(std::make_shared<store<json::object>>(object)) {}
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.object = new json::object(std::move(object));
+}
+inline value::value(json::object object, json::arena *arena)
+    : mType(TYPE_OBJECT),
+      mArena(nullptr != arena),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mOwning = arena && owning(object, arena);
+  mStorage.object = construct(std::move(object), arena);
+}
 inline value::value(json::pair pair)
-    : mType(TYPE_OBJECT), mStore(std::make_shared<store<json::object>>(pair)) {}
+    : mType(TYPE_OBJECT),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.object = new json::object(std::move(pair));
+}
 inline value::value(json::array array)
-    : mType(TYPE_ARRAY), mStore(std::make_shared<store<json::array>>(array)) {}
+    : mType(TYPE_ARRAY),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.array = new json::array(std::move(array));
+}
+inline value::value(json::array array, json::arena *arena)
+    : mType(TYPE_ARRAY),
+      mArena(nullptr != arena),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mOwning = arena && owning(array, arena);
+  mStorage.array = construct(std::move(array), arena);
+}
 inline value::value(int8_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_SIGNED) {
+  mStorage.integer = number;
+}
 inline value::value(int16_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_SIGNED) {
+  mStorage.integer = number;
+}
 inline value::value(int32_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_SIGNED) {
+  mStorage.integer = number;
+}
 inline value::value(int64_t number)
     : mType(TYPE_NUMBER),
-      mStore(std::make_shared<store<double>>(static_cast<double>(number))) {}
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_SIGNED) {
+  mStorage.integer = number;
+}
 inline value::value(uint8_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_UNSIGNED) {
+  mStorage.unsigned_integer = number;
+}
 inline value::value(uint16_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_UNSIGNED) {
+  mStorage.unsigned_integer = number;
+}
 inline value::value(uint32_t number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_UNSIGNED) {
+  mStorage.unsigned_integer = number;
+}
 inline value::value(uint64_t number)
     : mType(TYPE_NUMBER),
-      mStore(std::make_shared<store<double>>(static_cast<double>(number))) {}
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_UNSIGNED) {
+  mStorage.unsigned_integer = number;
+}
 inline value::value(float number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.number = number;
+}
 inline value::value(double number)
-    : mType(TYPE_NUMBER), mStore(std::make_shared<store<double>>(number)) {}
+    : mType(TYPE_NUMBER),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.number = number;
+}
 inline value::value(const char *string)
     : mType(TYPE_STRING),
-      mStore(std::make_shared<store<std::string>>(string)) {}
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.string = new std::string(string);
+}
 inline value::value(std::string string)
     : mType(TYPE_STRING),
-      mStore(std::make_shared<store<std::string>>(string)) {}
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.string = new std::string(std::move(string));
+}
+inline value::value(std::string string, json::arena *arena)
+    : mType(TYPE_STRING),
+      mArena(nullptr != arena),
+      mView(nullptr != arena),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  if (arena) {
+    // NOTE: Copy the characters to the arena and view them.
+    char *data = static_cast<char *>(arena->allocate(string.size(), 1));
+    std::char_traits<char>::copy(data, string.data(), string.size());
+    retain(json::view(data, string.size()), arena);
+  } else {
+    mStorage.string = new std::string(std::move(string));
+  }
+}
+inline value::value(json::view string, json::arena *arena)
+    : mType(TYPE_STRING),
+      mArena(nullptr != arena),
+      mView(nullptr != arena),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  if (arena) {
+    retain(string, arena);
+  } else {
+    mStorage.string = new std::string(string.data(), string.size());
+  }
+}
 inline value::value(bool boolean)
-    : mType(TYPE_BOOL), mStore(std::make_shared<store<bool>>(boolean)) {}
+    : mType(TYPE_BOOL),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(NUMBER_REAL) {
+  mStorage.boolean = boolean;
+}
+inline value::value(const json::value &other)
+    : mType(other.mType),
+      mArena(false),
+      mView(false),
+      mOwning(false),
+      mNumber(other.mNumber),
+      mStorage(other.mStorage) {
+  switch (mType) {
+    case TYPE_OBJECT:
+      mStorage.object = new json::object(*other.mStorage.object);
+      break;
+    case TYPE_ARRAY:
+      mStorage.array = new json::array(*other.mStorage.array);
+      break;
+    case TYPE_STRING: {
+      json::view string = other.view();
+      mStorage.string = new std::string(string.data(), string.size());
+    } break;
+    default:
+      break;
+  }
+}
+inline value::value(json::value &&other) noexcept
+    : mType(other.mType),
+      mArena(other.mArena),
+      mView(other.mView),
+      mOwning(other.mOwning),
+      mNumber(other.mNumber),
+      mStorage(other.mStorage) {
+  other.mType = TYPE_NULL;
+  other.mArena = false;
+  other.mView = false;
+  other.mOwning = false;
+  other.mStorage.number = 0;
+}
+inline value::~value() {
+  // NOTE: The arena releases everything the payload holds.
+  if (mArena && !mOwning) {
+    return;
+  }
+  switch (mType) {
+    case TYPE_OBJECT:
+      destroy(mStorage.object);
+      break;
+    case TYPE_ARRAY:
+      destroy(mStorage.array);
+      break;
+    case TYPE_STRING:
+      destroy(mStorage.string);
+      break;
+    default:
+      break;
+  }
+}
+
+inline json::value &value::operator=(json::value other) {
+  swap(other);
+  return *this;
+}
 
-#define CAST(Type) static_cast<store<Type> *>(mStore.get())->value
 inline json::type &value::type() { return mType; }
 inline const json::type &value::type() const { return mType; }
-inline json::object &value::object() { return CAST(json::object); }
-inline const json::object &value::object() const { return CAST(json::object); }
-inline json::array &value::array() { return CAST(json::array); }
-inline const json::array &value::array() const { return CAST(json::array); }
-inline double &value::number() { return CAST(double); }
-inline const double &value::number() const { return CAST(double); }
+inline json::object &value::object() {
+  // NOTE: Memory outside the arena may be added through the reference.
+  mOwning = true;
+  return *mStorage.object;
+}
+inline const json::object &value::object() const { return *mStorage.object; }
+inline json::array &value::array() {
+  mOwning = true;
+  return *mStorage.array;
+}
+inline const json::array &value::array() const { return *mStorage.array; }
+inline double &value::number() {
+  if (NUMBER_REAL != mNumber) {
+    mStorage.number = number<double>();
+    mNumber = NUMBER_REAL;
+  }
+  return mStorage.number;
+}
+inline double value::number() const { return number<double>(); }
 template <typename Number>
 Number value::number() {
-  return static_cast<Number>(CAST(double));
+  return static_cast<const json::value &>(*this).number<Number>();
 }
 template <typename Number>
 Number value::number() const {
-  return static_cast<Number>(CAST(double));
+  switch (mNumber) {
+    case NUMBER_SIGNED:
+      return static_cast<Number>(mStorage.integer);
+    case NUMBER_UNSIGNED:
+      return static_cast<Number>(mStorage.unsigned_integer);
+    default:
+      return static_cast<Number>(mStorage.number);
+  }
+}
+inline bool value::integer() const { return NUMBER_REAL != mNumber; }
+inline std::string &value::string() {
+  materialize();
+  return *mStorage.string;
+}
+inline const std::string &value::string() const {
+  materialize();
+  return *mStorage.string;
+}
+inline json::view value::view() const {
+  if (mView) {
+    return reinterpret_cast<const arena_view *>(mStorage.string)->string;
+  }
+  return *mStorage.string;
+}
+inline bool &value::boolean() { return mStorage.boolean; }
+inline const bool &value::boolean() const { return mStorage.boolean; }
+
+inline void value::swap(json::value &other) {
+  std::swap(mType, other.mType);
+  std::swap(mArena, other.mArena);
+  std::swap(mView, other.mView);
+  std::swap(mOwning, other.mOwning);
+  std::swap(mNumber, other.mNumber);
+  std::swap(mStorage, other.mStorage);
 }
-inline std::string &value::string() { return CAST(std::string); }
-inline const std::string &value::string() const { return CAST(std::string); }
-inline bool &value::boolean() { return CAST(bool); }
-inline const bool &value::boolean() const { return CAST(bool); }
-#undef CAST
+
+template <typename Type>
+inline Type *value::construct(Type &&payload, json::arena *arena) {
+  if (arena) {
+    return new (arena->allocate(sizeof(Type), alignof(Type)))
+        Type(std::move(payload));
+  }
+  return new Type(std::move(payload));
+}
+template <typename Type>
+inline void value::destroy(Type *payload) {
+  if (mArena) {
+    payload->~Type();
+  } else {
+    delete payload;
+  }
+}
+
+inline void value::retain(const json::view &string, json::arena *arena) {
+  // NOTE: Reserve space to construct the string in when it is accessed.
+  static_assert(sizeof(arena_view) <= sizeof(std::string),
+                "the view of a string must fit in the space of a std::string");
+  void *payload = arena->allocate(sizeof(std::string), alignof(std::string));
+  mStorage.string =
+      reinterpret_cast<std::string *>(new (payload) arena_view{string, arena});
+}
+inline void value::materialize() const {
+  if (mView) {
+    // NOTE: The view is trivially destructible, replace it in place.
+    arena_view retained = *reinterpret_cast<arena_view *>(mStorage.string);
+    new (mStorage.string)
+        std::string(retained.string.data(), retained.string.size());
+    retained.arena->own(mStorage.string, destroy_string);
+    mView = false;
+  }
+}
+inline void value::destroy_string(void *string) {
+  static_cast<std::string *>(string)->~basic_string();
+}
+inline bool value::owning() const {
+  if (mArena) {
+    return mOwning;
+  }
+  return TYPE_STRING == mType || TYPE_OBJECT == mType || TYPE_ARRAY == mType;
+}
+
+inline bool value::owning(const json::object &object,
+                          const json::arena *arena) {
+  if (arena != object.mEntries.get_allocator().arena ||
+      arena != object.mIndex.get_allocator().arena) {
+    return true;
+  }
+  for (auto &entry : object.mEntries) {
+    // NOTE: Short keys are stored within the std::string.
+    const char *key = entry.first.data();
+    const char *inside = reinterpret_cast<const char *>(&entry.first);
+    if (std::less<const char *>()(key, inside) ||
+        !std::less<const char *>()(key, inside + sizeof(entry.first)) ||
+        entry.second.owning()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool value::owning(const json::array &array,
+                          const json::arena *arena) {
+  if (arena != array.mEntries.get_allocator().arena) {
+    return true;
+  }
+  for (auto &entry : array.mEntries) {
+    if (entry.owning()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline view::view() : mData(""), mSize(0) {}
+inline view::view(const char *data, size_t size) : mData(data), mSize(size) {}
+inline view::view(const std::string &string)
+    : mData(string.data()), mSize(string.size()) {}
+inline const char *view::data() const { return mData; }
+inline size_t view::size() const { return mSize; }
+inline std::string view::str() const { return std::string(mData, mSize); }
+inline bool operator==(const json::view &lhs, const json::view &rhs) {
+  return lhs.size() == rhs.size() &&
+         0 == std::char_traits<char>::compare(lhs.data(), rhs.data(),
+                                              lhs.size());
+}
+inline bool operator!=(const json::view &lhs, const json::view &rhs) {
+  return !(lhs == rhs);
+}
+
+inline document::document() : mArena(), mRoot() {}
+inline json::value &document::root() { return mRoot; }
+inline const json::value &document::root() const { return mRoot; }
+inline json::arena &document::arena() { return mArena; }
+
+inline node::iterator::iterator(const json::node *node, bool object)
+    : mNode(node), mObject(object) {}
+inline const json::node &node::iterator::operator*() const { return *mNode; }
+inline const json::node *node::iterator::operator->() const { return mNode; }
+inline const json::node &node::iterator::value() const { return mNode[1]; }
+inline node::iterator &node::iterator::operator++() {
+  mNode = mObject ? mNode[1].next() : mNode->next();
+  return *this;
+}
+inline bool node::iterator::operator==(const iterator &other) const {
+  return mNode == other.mNode;
+}
+inline bool node::iterator::operator!=(const iterator &other) const {
+  return mNode != other.mNode;
+}
+
+inline node::node(json::type type, const char *data, size_t size)
+    : mData(data),
+      mSize(static_cast<uint32_t>(size)),
+      mSkip(0),
+      mType(type),
+      mEscaped(false) {}
+inline json::type node::type() const { return mType; }
+inline const json::node &node::object() const { return *this; }
+inline const json::node &node::array() const { return *this; }
+inline const json::node *node::get(const char *key) const {
+  return get(json::view(key, std::char_traits<char>::length(key)));
+}
+inline node::iterator node::begin() const {
+  return iterator(this + 1, TYPE_OBJECT == mType);
+}
+inline node::iterator node::end() const {
+  return iterator(next(), TYPE_OBJECT == mType);
+}
+inline size_t node::size() const { return mSize; }
+inline double node::number() const { return number<double>(); }
+template <typename Number>
+Number node::number() const {
+  // NOTE: Numbers are stored inline, reading one does not allocate.
+  return value().number<Number>();
+}
+inline bool node::integer() const { return value().integer(); }
+inline json::view node::view() const { return json::view(mData, mSize); }
+inline bool node::escaped() const { return mEscaped; }
+inline bool node::boolean() const { return 't' == *mData; }
+inline const json::node *node::next() const { return this + 1 + mSkip; }
+
+inline tape::tape() : mSource(), mNodes{json::node(TYPE_NULL, "null", 4)} {}
+inline const json::node &tape::root() const { return mNodes.front(); }
 }
 
 #endif
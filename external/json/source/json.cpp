@@ -20,22 +20,181 @@
 
 #include <json/json.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
-#include <iomanip>
-#include <sstream>
+#include <clocale>
+#include <limits>
 
-struct indent_t {
-  indent_t(const char *str) : str(str), count(0) {}
+// NOTE: Scanning kernels are selected at compile time, AVX2 when enabled by
+// the JSON_AVX2 option, otherwise SSE2 which is the x86-64 baseline. Scalar
+// code handles the tail of the data and all other architectures.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_SCAN_AVX2
+#define JSON_SCAN_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SCAN_SSE2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <locale.h>
+#elif defined(__APPLE__)
+#include <xlocale.h>
+#else
+#include <locale.h>
+#endif
+// NOTE: C++11 has no standard attribute to mark intended fall through.
+#if defined(__clang__)
+#define JSON_FALLTHROUGH [[clang::fallthrough]]
+#elif defined(__GNUC__) && 7 <= __GNUC__
+#define JSON_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define JSON_FALLTHROUGH
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define JSON_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-  void operator++(int) { count++; }
-  void operator--(int) { count--; }
+struct output_t {
+  output_t(std::string &buffer, FILE *file, const char *tab)
+      : buffer(buffer),
+        file(file),
+        tab(tab),
+        tab_size(tab ? std::strlen(tab) : 0),
+        depth(0),
+        failed(false) {}
 
-  const char *str;
-  size_t count;
+  void put(const char c) { buffer.push_back(c); }
+  void put(const char *data, size_t size) { buffer.append(data, size); }
+
+  /// @brief Start a new line when pretty printing.
+  void newline() {
+    if (tab) {
+      buffer.push_back('\n');
+      for (size_t count = 0; count < depth; count++) {
+        buffer.append(tab, tab_size);
+      }
+    }
+  }
+
+  /// @brief Write the buffer to the file once it is large enough.
+  void spill() {
+    if (file && 64 * 1024 <= buffer.size()) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (file && !buffer.empty()) {
+      failed |= buffer.size() != fwrite(buffer.data(), 1, buffer.size(), file);
+      buffer.clear();
+    }
+  }
+
+  std::string &buffer;
+  FILE *file;
+  // NOTE: Null when writing compact output.
+  const char *tab;
+  size_t tab_size;
+  size_t depth;
+  bool failed;
+};
+
+// A read only view of the contents of a file followed by a null terminator
+struct mapping_t {
+  mapping_t(const std::string &path)
+      : data(nullptr), size(0), base(nullptr), length(0) {
+#if defined(JSON_MMAP)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (-1 == fd) {
+      return;
+    }
+    struct stat info;
+    if (0 == fstat(fd, &info) && S_ISREG(info.st_mode)) {
+      size = static_cast<size_t>(info.st_size);
+      // NOTE: Reserve at least one byte past the end of the file, the part of
+      // the last page beyond the file and the reserved pages read as zero so
+      // the contents are always null terminated.
+      const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+      length = (size / page + 1) * page;
+      void *reserved = mmap(nullptr, length, PROT_READ,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (MAP_FAILED != reserved) {
+        base = reserved;
+        if (0 == size ||
+            MAP_FAILED != mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+                               fd, 0)) {
+          data = static_cast<const char *>(base);
+          if (size) {
+            madvise(base, size, MADV_SEQUENTIAL);
+          }
+        }
+      }
+    }
+    close(fd);
+#else
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      return;
+    }
+    char chunk[64 * 1024];
+    size_t count;
+    while (0 < (count = std::fread(chunk, 1, sizeof(chunk), file))) {
+      buffer.append(chunk, count);
+    }
+    if (!std::ferror(file)) {
+      data = buffer.c_str();
+      size = buffer.size();
+    }
+    std::fclose(file);
+#endif
+  }
+
+  ~mapping_t() {
+#if defined(JSON_MMAP)
+    if (base) {
+      munmap(base, length);
+    }
+#endif
+  }
+
+  /// @brief Release the pages before offset which have been read.
+  void discard(size_t offset) {
+#if defined(JSON_MMAP)
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    madvise(base, offset / page * page, MADV_DONTNEED);
+#else
+    (void)offset;
+#endif
+  }
+
+  // NOTE: Null when the file could not be read.
+  const char *data;
+  size_t size;
+
+ private:
+  mapping_t(const mapping_t &) = delete;
+  mapping_t &operator=(const mapping_t &) = delete;
+
+  void *base;
+  size_t length;
+#if !defined(JSON_MMAP)
+  std::string buffer;
+#endif
 };
 
 struct position_t {
-  position_t() : line(1), column(1), index(0) {}
+  position_t(size_t size) : line(1), column(1), index(0), size(size) {}
 
   position_t &operator++() {
     column++;
@@ -56,6 +215,8 @@ struct position_t {
   size_t line;
   size_t column;
   size_t index;
+  // NOTE: Length of the stream, scans never read past it.
+  size_t size;
 };
 
 struct diagnostic_t {
@@ -66,33 +227,304 @@ struct diagnostic_t {
   const char *error;
 };
 
-bool consume_whitespace(const char *str, position_t &pos) {
-  while (true) {
-    switch (str[pos.index]) {
-      case ' ':
-      case '\t':
-        pos++;
+void append_utf8(uint32_t code, std::string &string) {
+  if (0x80 > code) {
+    // NOTE: Write single byte UTF-8 code point
+    string.push_back(static_cast<char>(code));
+  } else if (0x800 > code) {
+    // NOTE: Write two byte UTF-8 code point
+    string.push_back(static_cast<char>(0xc0 | (code >> 6)));
+    string.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+  } else {
+    // NOTE: Write three byte UTF-8 code point
+    string.push_back(static_cast<char>(0xe0 | ((code >> 12) & 0xf)));
+    string.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+    string.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+  }
+}
+
+/// @brief Decode the 4 hexadecimal digits of a '\\u' escape, returns the
+/// number of digits found which is less than 4 on failure.
+size_t read_hex(const char *begin, const char *end, uint32_t &code) {
+  code = 0;
+  size_t digit = 0;
+  for (; digit < 4 && end - begin > static_cast<ptrdiff_t>(digit); digit++) {
+    const unsigned char c = static_cast<unsigned char>(begin[digit]);
+    if (!std::isxdigit(c)) {
+      break;
+    }
+    code = code << 4 | (std::isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+  }
+  return digit;
+}
+
+#if defined(JSON_SCAN_SSE2)
+/// @brief Index of the lowest set bit of a non-zero mask.
+inline uint32_t first_bit(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+/// @brief Index of the highest set bit of a non-zero mask.
+inline uint32_t last_bit(uint32_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse(&index, mask);
+  return index;
+#else
+  return 31 - __builtin_clz(mask);
+#endif
+}
+
+inline uint32_t count_bits(uint32_t mask) {
+#if defined(_MSC_VER)
+  return __popcnt(mask);
+#else
+  return __builtin_popcount(mask);
+#endif
+}
+#endif
+
+inline bool whitespace(const char c) {
+  return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
+
+/// @brief Check if a string character ends a run which needs no unescaping,
+/// quotes, reverse solidus and raw control characters.
+inline bool special(const char c) {
+  return '"' == c || '\\' == c || 0x20 > static_cast<unsigned char>(c);
+}
+
+/// @brief Find the first character which is not whitespace.
+///
+/// @param[out] lines Incremented by the number of newlines skipped.
+/// @param[out] line Set to the start of the last line skipped, if any.
+const char *skip_whitespace(const char *begin, const char *end, size_t &lines,
+                            const char *&line) {
+#if defined(JSON_SCAN_AVX2)
+  const __m256i space256 = _mm256_set1_epi8(' ');
+  const __m256i tab256 = _mm256_set1_epi8('\t');
+  const __m256i newline256 = _mm256_set1_epi8('\n');
+  const __m256i carriage256 = _mm256_set1_epi8('\r');
+  for (; end - begin >= 32; begin += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    __m256i newlines = _mm256_cmpeq_epi8(chunk, newline256);
+    __m256i spaces = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space256),
+                        _mm256_cmpeq_epi8(chunk, tab256)),
+        _mm256_or_si256(newlines, _mm256_cmpeq_epi8(chunk, carriage256)));
+    uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(spaces));
+    uint32_t breaks = static_cast<uint32_t>(_mm256_movemask_epi8(newlines));
+    if (other) {
+      breaks &= (1u << first_bit(other)) - 1;
+    }
+    if (breaks) {
+      lines += count_bits(breaks);
+      line = begin + last_bit(breaks) + 1;
+    }
+    if (other) {
+      return begin + first_bit(other);
+    }
+  }
+#endif
+#if defined(JSON_SCAN_SSE2)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage = _mm_set1_epi8('\r');
+  for (; end - begin >= 16; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    __m128i newlines = _mm_cmpeq_epi8(chunk, newline);
+    __m128i spaces = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+        _mm_or_si128(newlines, _mm_cmpeq_epi8(chunk, carriage)));
+    uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(spaces)) & 0xffff;
+    uint32_t breaks = static_cast<uint32_t>(_mm_movemask_epi8(newlines));
+    if (other) {
+      breaks &= (1u << first_bit(other)) - 1;
+    }
+    if (breaks) {
+      lines += count_bits(breaks);
+      line = begin + last_bit(breaks) + 1;
+    }
+    if (other) {
+      return begin + first_bit(other);
+    }
+  }
+#endif
+  for (; begin != end && whitespace(*begin); begin++) {
+    if ('\n' == *begin) {
+      lines++;
+      line = begin + 1;
+    }
+  }
+  return begin;
+}
+
+/// @brief Find the first special character of a string.
+const char *scan_string(const char *begin, const char *end) {
+#if defined(JSON_SCAN_AVX2)
+  const __m256i quote256 = _mm256_set1_epi8('"');
+  const __m256i solidus256 = _mm256_set1_epi8('\\');
+  const __m256i control256 = _mm256_set1_epi8(0x1f);
+  for (; end - begin >= 32; begin += 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+    // NOTE: Unsigned characters not above 0x1f are control characters.
+    __m256i found = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote256),
+                        _mm256_cmpeq_epi8(chunk, solidus256)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control256), chunk));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(found));
+    if (mask) {
+      return begin + first_bit(mask);
+    }
+  }
+#endif
+#if defined(JSON_SCAN_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i solidus = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  for (; end - begin >= 16; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+    __m128i found = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, solidus)),
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(found));
+    if (mask) {
+      return begin + first_bit(mask);
+    }
+  }
+#endif
+  for (; begin != end && !special(*begin); begin++) {
+  }
+  return begin;
+}
+
+/// @brief Start a UTF-8 sequence from its lead byte.
+///
+/// @param[out] remaining Number of continuation bytes which must follow.
+/// @param[out] low Lowest valid value of the next byte.
+/// @param[out] high Highest valid value of the next byte.
+///
+/// @return Returns false if the byte can not start a sequence.
+bool utf8_lead(const unsigned char c, size_t &remaining, unsigned char &low,
+               unsigned char &high) {
+  low = 0x80;
+  high = 0xbf;
+  if (0xc2 <= c && 0xdf >= c) {
+    remaining = 1;
+  } else if (0xe0 <= c && 0xef >= c) {
+    // NOTE: Reject overlong encodings and UTF-16 surrogates.
+    remaining = 2;
+    low = 0xe0 == c ? 0xa0 : 0x80;
+    high = 0xed == c ? 0x9f : 0xbf;
+  } else if (0xf0 <= c && 0xf4 >= c) {
+    // NOTE: Reject overlong encodings and code points above U+10FFFF.
+    remaining = 3;
+    low = 0xf0 == c ? 0x90 : 0x80;
+    high = 0xf4 == c ? 0x8f : 0xbf;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Find the end of the UTF-8 sequence starting at begin.
+///
+/// @return Returns begin if the sequence is invalid or incomplete.
+const char *utf8_sequence(const char *begin, const char *end) {
+  size_t remaining;
+  unsigned char low, high;
+  if (!utf8_lead(*begin, remaining, low, high)) {
+    return begin;
+  }
+  const char *next = begin + 1;
+  for (; remaining; remaining--, next++) {
+    if (end == next) {
+      return begin;
+    }
+    const unsigned char c = *next;
+    if (low > c || high < c) {
+      return begin;
+    }
+    low = 0x80;
+    high = 0xbf;
+  }
+  return next;
+}
+
+/// @brief Find the first invalid or incomplete UTF-8 sequence.
+const char *validate_utf8(const char *begin, const char *end) {
+  while (begin != end) {
+    // NOTE: Skip ASCII a vector at a time, sequences are checked one by one.
+#if defined(JSON_SCAN_AVX2)
+    for (; end - begin >= 32; begin += 32) {
+      uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin))));
+      if (mask) {
+        begin += first_bit(mask);
         break;
-      case '\n':
-        pos.line++;
-        pos.column = 1;
-        pos.index++;
+      }
+    }
+#endif
+#if defined(JSON_SCAN_SSE2)
+    for (; end - begin >= 16; begin += 16) {
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin))));
+      if (mask) {
+        begin += first_bit(mask);
         break;
-      case '\0':
-        return false;
-      default:
-        return true;
+      }
     }
+#endif
+    if (begin == end) {
+      break;
+    }
+    if (!(0x80 & *begin)) {
+      begin++;
+      continue;
+    }
+    const char *next = utf8_sequence(begin, end);
+    if (next == begin) {
+      return begin;
+    }
+    begin = next;
+  }
+  return end;
+}
+
+bool consume_whitespace(const char *str, position_t &pos) {
+  const char *begin = str + pos.index;
+  size_t lines = 0;
+  const char *line = nullptr;
+  const char *end = skip_whitespace(begin, str + pos.size, lines, line);
+  if (lines) {
+    pos.line += lines;
+    pos.column = end - line + 1;
+  } else {
+    pos.column += end - begin;
   }
+  pos.index += end - begin;
+  return '\0' != *end;
 }
 
 std::string read_string(const char *str, position_t &pos, diagnostic_t &diag);
 
-json::value read_value(const char *str, position_t &pos, diagnostic_t &diag);
+json::value read_value(const char *str, position_t &pos, diagnostic_t &diag,
+                       json::arena *arena);
 
-json::object read_object(const char *str, position_t &pos, diagnostic_t &diag) {
+json::object read_object(const char *str, position_t &pos, diagnostic_t &diag,
+                         json::arena *arena) {
   pos++;
-  json::object object;
+  json::object object(arena);
   while (true) {
     if (!consume_whitespace(str, pos)) {
       diag.error =
@@ -124,12 +556,12 @@ json::object read_object(const char *str, position_t &pos, diagnostic_t &diag) {
           diag.error = "Expected data value before reaching end of stream.";
           return {};
         }
-        auto value = read_value(str, pos, diag);
+        auto value = read_value(str, pos, diag, arena);
         if (diag) {
           // NOTE: Piggy back on diagnostic set by read_value
           return {};
         }
-        object.add({key, value});
+        object.add(std::move(key), std::move(value));
       } break;
       case '}': {
         pos++;
@@ -148,9 +580,10 @@ json::object read_object(const char *str, position_t &pos, diagnostic_t &diag) {
   return {};
 }
 
-json::array read_array(const char *str, position_t &pos, diagnostic_t &diag) {
+json::array read_array(const char *str, position_t &pos, diagnostic_t &diag,
+                       json::arena *arena) {
   pos++;
-  json::array array;
+  json::array array(arena);
   while (true) {
     if (!consume_whitespace(str, pos)) {
       diag.error = "Reached end of stream whilst attempting to read array.";
@@ -178,12 +611,12 @@ json::array read_array(const char *str, position_t &pos, diagnostic_t &diag) {
       case 't':
       case 'f':
       case 'n': {
-        auto value = read_value(str, pos, diag);
+        auto value = read_value(str, pos, diag, arena);
         if (diag) {
           // NOTE: Piggy back on diagnostic set by read_value
           return {};
         }
-        array.append(value);
+        array.append(std::move(value));
       } break;
       case ']': {
         pos++;
@@ -202,12 +635,147 @@ json::array read_array(const char *str, position_t &pos, diagnostic_t &diag) {
   return {};
 }
 
-double read_number(const char *str, position_t &pos, diagnostic_t &diag) {
-  const char *start = str + pos.index;
-  char *end = nullptr;
-  double number = strtod(start, &end);
-  pos += end - start;
-  return number;
+/// @brief Parse an integer literal exactly, without the locale dependence of
+/// strtod.
+///
+/// @return Returns false if the literal is not an integer or does not fit in
+/// 64 bits.
+bool parse_integer(const char *begin, const char *end, bool &negative,
+                   uint64_t &magnitude) {
+  negative = begin != end && '-' == *begin;
+  if (negative) {
+    begin++;
+  }
+  if (begin == end) {
+    return false;
+  }
+  magnitude = 0;
+  for (; begin != end; begin++) {
+    const uint32_t digit = static_cast<unsigned char>(*begin) - '0';
+    if (9 < digit) {
+      return false;
+    }
+    if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  return !negative || magnitude <= uint64_t(1) << 63;
+}
+
+/// @brief Negate the magnitude of a negative integer without overflow.
+inline int64_t negate(const uint64_t magnitude) {
+  return magnitude ? -static_cast<int64_t>(magnitude - 1) - 1 : 0;
+}
+
+/// @brief Check if a character may continue a number.
+inline bool number_character(const char c) {
+  return std::isdigit(static_cast<unsigned char>(c)) || '+' == c || '-' == c ||
+         '.' == c || 'e' == c || 'E' == c;
+}
+
+/// @brief Find the end of a number following the JSON grammar exactly, all
+/// readers accept the same numbers.
+///
+/// @param[out] error Set if the characters are not a number, or the number is
+/// followed by characters which could continue it such as a leading zero.
+///
+/// @return Returns the end of the number, or the position of the error.
+const char *scan_number(const char *begin, const char *end,
+                        const char *&error) {
+  auto digits = [end](const char *cursor) {
+    while (end != cursor && std::isdigit(static_cast<unsigned char>(*cursor))) {
+      cursor++;
+    }
+    return cursor;
+  };
+  const char *cursor = begin;
+  if (end != cursor && '-' == *cursor) {
+    cursor++;
+  }
+  if (end != cursor && '0' == *cursor) {
+    cursor++;
+  } else {
+    const char *next = digits(cursor);
+    if (next == cursor) {
+      error = "Expected a digit whilst attempting to read number.";
+      return cursor;
+    }
+    cursor = next;
+  }
+  if (end != cursor && '.' == *cursor) {
+    cursor++;
+    const char *next = digits(cursor);
+    if (next == cursor) {
+      error = "Expected a digit following '.' in number.";
+      return cursor;
+    }
+    cursor = next;
+  }
+  if (end != cursor && ('e' == *cursor || 'E' == *cursor)) {
+    cursor++;
+    if (end != cursor && ('+' == *cursor || '-' == *cursor)) {
+      cursor++;
+    }
+    const char *next = digits(cursor);
+    if (next == cursor) {
+      error = "Expected a digit in the exponent of number.";
+      return cursor;
+    }
+    cursor = next;
+  }
+  if (end != cursor && number_character(*cursor)) {
+    error = "Invalid number.";
+  }
+  return cursor;
+}
+
+/// @brief Convert text to a double in the C locale, the decimal point of the
+/// current locale is ignored.
+double c_strtod(const char *str, char **end) {
+#if defined(_MSC_VER)
+  static _locale_t locale = _create_locale(LC_NUMERIC, "C");
+  return _strtod_l(str, end, locale);
+#else
+  static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+  return strtod_l(str, end, locale);
+#endif
+}
+
+/// @brief Convert a number found by scan_number, integers which fit in 64
+/// bits are exact, others are the nearest double.
+json::value number_value(const char *begin, const char *end) {
+  bool negative;
+  uint64_t magnitude;
+  if (parse_integer(begin, end, negative, magnitude)) {
+    if (negative) {
+      return json::value(negate(magnitude));
+    }
+    return json::value(magnitude);
+  }
+  // NOTE: The number may not be followed by a null terminator.
+  char buffer[64];
+  std::string copy;
+  const char *str = buffer;
+  const size_t size = end - begin;
+  if (size < sizeof(buffer)) {
+    std::memcpy(buffer, begin, size);
+    buffer[size] = '\0';
+  } else {
+    copy.assign(begin, end);
+    str = copy.c_str();
+  }
+  return json::value(c_strtod(str, nullptr));
+}
+
+json::value read_number(const char *str, position_t &pos, diagnostic_t &diag) {
+  const char *begin = str + pos.index;
+  const char *end = scan_number(begin, str + pos.size, diag.error);
+  pos += end - begin;
+  if (diag) {
+    return {};
+  }
+  return number_value(begin, end);
 }
 
 std::string read_string(const char *str, position_t &pos, diagnostic_t &diag) {
@@ -257,40 +825,25 @@ std::string read_string(const char *str, position_t &pos, diagnostic_t &diag) {
           } break;
           case 'u': {  // NOTE: 4 hexadecimal digits
             pos++;
-            char hex[6] = {'0',
-                           'x',
-                           str[pos.index + 0],
-                           str[pos.index + 1],
-                           str[pos.index + 2],
-                           str[pos.index + 3]};
-            char *end = nullptr;
-            uint32_t code = std::strtoul(hex, &end, 16);
-            if (hex + 6 != end) {
-              pos += end - hex - 2;
+            uint32_t code;
+            const size_t digits =
+                read_hex(str + pos.index, str + pos.size, code);
+            if (4 != digits) {
+              pos += digits;
               diag.error = "Did not find 4 hexadecimal digits.";
               return {};
             }
-            if (0xf800 & code) {
-              // NOTE: Write three byte UTF-8 code point
-              ret.push_back(0xe0 | ((code >> 12) & 0xf));
-              ret.push_back(0x80 | ((code >> 6) & 0x3f));
-              ret.push_back(0x80 | (code & 0x3f));
-            } else if (0xf80 & code) {
-              // NOTE: Write two byte UTF-8 code point
-              ret.push_back(0xc0 | ((code >> 6) & 0x3f));
-              ret.push_back(0x80 | (code & 0x3f));
-            } else if (0x7f & code) {
-              // NOTE: Write single byte UTF-8 code point
-              ret.push_back(0x40 | (code & 0x7f));
-            } else {
+            if (!code) {
               diag.error = "Found invalid UTF-8 control character.";
               return {};
             }
+            append_utf8(code, ret);
             pos += 4;
           } break;
           default: {
-            diag.error = "Found invalid control character following '\'.";
-          } break;
+            diag.error = "Found invalid control character following '\\'.";
+            return {};
+          }
         }
       } break;
       case '\0': {
@@ -308,9 +861,20 @@ std::string read_string(const char *str, position_t &pos, diagnostic_t &diag) {
         diag.error = "Found invalid raw control character.";
         return {};
       } break;
-      default: {  // NOTE: Valid normal character
-        ret.push_back(str[pos.index]);
-        pos++;
+      default: {  // NOTE: Run of valid normal characters
+        const char *begin = str + pos.index;
+        const char *end =
+            validate_utf8(begin, scan_string(begin, str + pos.size));
+        if (begin == end) {
+          if (0x80 & *begin) {
+            diag.error = "Found invalid UTF-8 sequence.";
+            return {};
+          }
+          // NOTE: Other raw control characters are kept.
+          end++;
+        }
+        ret.append(begin, end);
+        pos += end - begin;
       } break;
     }
   }
@@ -319,7 +883,8 @@ std::string read_string(const char *str, position_t &pos, diagnostic_t &diag) {
   return {};
 }
 
-json::value read_value(const char *str, position_t &pos, diagnostic_t &diag) {
+json::value read_value(const char *str, position_t &pos, diagnostic_t &diag,
+                       json::arena *arena) {
   if (!consume_whitespace(str, pos)) {
     diag.error = "Reached end of stream whilst attempting to read value.";
     return {};
@@ -327,10 +892,10 @@ json::value read_value(const char *str, position_t &pos, diagnostic_t &diag) {
 
   switch (str[pos.index]) {
     case '{': {
-      return json::value(read_object(str, pos, diag));
+      return json::value(read_object(str, pos, diag, arena), arena);
     }
     case '[': {
-      return json::value(read_array(str, pos, diag));
+      return json::value(read_array(str, pos, diag, arena), arena);
     }
     case '-':
     case '0':
@@ -343,10 +908,20 @@ json::value read_value(const char *str, position_t &pos, diagnostic_t &diag) {
     case '7':
     case '8':
     case '9': {
-      return json::value(read_number(str, pos, diag));
+      return read_number(str, pos, diag);
     }
     case '"': {
-      return json::value(read_string(str, pos, diag));
+      if (arena) {
+        // NOTE: The arena retains the source, view strings without escapes.
+        const char *begin = str + pos.index + 1;
+        const char *end =
+            validate_utf8(begin, scan_string(begin, str + pos.size));
+        if ('"' == *end) {
+          pos += end - begin + 2;
+          return json::value(json::view(begin, end - begin), arena);
+        }
+      }
+      return json::value(read_string(str, pos, diag), arena);
     }
     case 't': {
       if ('r' == str[pos.index + 1] && 'u' == str[pos.index + 2] &&
@@ -390,133 +965,1433 @@ json::value read_value(const char *str, position_t &pos, diagnostic_t &diag) {
 }
 
 json::value json::read(const std::string &string, bool diag_on) {
-  position_t pos;
+  position_t pos(string.size());
   diagnostic_t diag;
-  json::value value = read_value(string.c_str(), pos, diag);
+  json::value value = read_value(string.c_str(), pos, diag, nullptr);
   if (diag_on && diag) {
     fprintf(stderr, "error: %zu:%zu: %s\n", pos.line, pos.column, diag.error);
   }
   return value;
 }
 
-void push(const indent_t &indent, std::stringstream &stream) {
-  for (uint32_t i = 0; i < indent.count; ++i) {
-    stream << indent.str;
+json::value &json::read(const std::string &string, json::document &document,
+                        bool diag_on) {
+  position_t pos(string.size());
+  diagnostic_t diag;
+  // NOTE: Retain the source so strings without escapes can be views of it.
+  char *source = static_cast<char *>(
+      document.arena().allocate(string.size() + 1, 1));
+  std::memcpy(source, string.c_str(), string.size() + 1);
+  document.root() = read_value(source, pos, diag, &document.arena());
+  if (diag_on && diag) {
+    fprintf(stderr, "error: %zu:%zu: %s\n", pos.line, pos.column, diag.error);
   }
+  return document.root();
 }
 
-void write_value(const json::value &value, indent_t &indent,
-                 std::stringstream &stream);
+bool json::read(const std::string &string, json::handler &handler,
+                bool diag_on) {
+  json::parser parser(handler);
+  if (!parser.feed(string) || !parser.finish()) {
+    if (diag_on) {
+      fprintf(stderr, "error: %zu:%zu: %s\n", parser.line(), parser.column(),
+              parser.error());
+    }
+    return false;
+  }
+  return true;
+}
 
-void write_string(const std::string &string, indent_t &indent,
-                  std::stringstream &stream);
+bool json::read(std::string string, json::tape &tape, bool diag_on) {
+  tape.mSource = std::move(string);
+  tape.mNodes.clear();
+  const char *begin = tape.mSource.data();
+  const char *end = begin + tape.mSource.size();
+  const char *error = nullptr;
+  const char *cursor = begin;
+  if (std::numeric_limits<uint32_t>::max() <= tape.mSource.size()) {
+    error = "Document is too large to record on a tape.";
+  } else {
+    // NOTE: Typical documents record a node for every eight characters or
+    // more, reserve that many to avoid growing the tape while recording.
+    tape.mNodes.reserve(tape.mSource.size() / 8 + 1);
+    cursor = tape.record(begin, end, error);
+    if (!error) {
+      size_t lines = 0;
+      const char *line = nullptr;
+      cursor = skip_whitespace(cursor, end, lines, line);
+      if (end != cursor) {
+        error = "Unexpected character after the end of the value.";
+      }
+    }
+  }
+  if (error) {
+    if (diag_on) {
+      // NOTE: Positions are only needed for diagnostics, find them now.
+      const size_t line = 1 + std::count(begin, cursor, '\n');
+      const char *start = cursor;
+      while (begin != start && '\n' != start[-1]) {
+        start--;
+      }
+      fprintf(stderr, "error: %zu:%zu: %s\n", line,
+              static_cast<size_t>(cursor - start) + 1, error);
+    }
+    tape.mNodes.assign(1, json::node(TYPE_NULL, "null", 4));
+    return false;
+  }
+  return true;
+}
 
-void write_object(const json::object &object, indent_t &indent,
-                  std::stringstream &stream) {
-  stream << "{";
-  indent++;
-  bool first = true;
-  for (auto &pair : object) {
-    if (!first) {
-      stream << ",";
+json::value json::read_file(const std::string &path, bool diag_on) {
+  mapping_t file(path);
+  if (!file.data) {
+    if (diag_on) {
+      fprintf(stderr, "error: %s: could not read file\n", path.c_str());
     }
-    stream << "\n";
-    push(indent, stream);
-    write_string(pair.first, indent, stream);
-    stream << ": ";
-    write_value(pair.second, indent, stream);
-    first = false;
+    return {};
   }
-  indent--;
-  stream << "\n";
-  push(indent, stream);
-  stream << "}";
+  position_t pos(file.size);
+  diagnostic_t diag;
+  json::value value = read_value(file.data, pos, diag, nullptr);
+  if (diag_on && diag) {
+    fprintf(stderr, "error: %s:%zu:%zu: %s\n", path.c_str(), pos.line,
+            pos.column, diag.error);
+  }
+  return value;
 }
 
-void write_array(const json::array &array, indent_t &indent,
-                 std::stringstream &stream) {
-  stream << "[";
-  indent++;
-  bool first = true;
-  for (auto &value : array) {
-    if (!first) {
-      stream << ",";
+bool json::read_file(const std::string &path, json::handler &handler,
+                     bool diag_on) {
+  mapping_t file(path);
+  if (!file.data) {
+    if (diag_on) {
+      fprintf(stderr, "error: %s: could not read file\n", path.c_str());
     }
-    stream << "\n";
-    push(indent, stream);
-    write_value(value, indent, stream);
-    first = false;
+    return false;
+  }
+  // NOTE: The parser copies what it retains, feed the file a chunk at a time
+  // and release the pages already read so large files use constant memory.
+  json::parser parser(handler);
+  const size_t chunk = 4 * 1024 * 1024;
+  bool success = true;
+  for (size_t offset = 0; success && offset < file.size; offset += chunk) {
+    success = parser.feed(file.data + offset,
+                          std::min(chunk, file.size - offset));
+    file.discard(offset);
+  }
+  if (!success || !parser.finish()) {
+    if (diag_on) {
+      fprintf(stderr, "error: %s:%zu:%zu: %s\n", path.c_str(), parser.line(),
+              parser.column(), parser.error());
+    }
+    return false;
+  }
+  return true;
+}
+
+const char *json::tape::record(const char *begin, const char *end,
+                               const char *&error) {
+  enum state { STATE_VALUE, STATE_KEY, STATE_NEXT };
+  state state = STATE_VALUE;
+  // NOTE: Positions of the objects and arrays which are still open.
+  std::vector<size_t> open;
+  size_t lines = 0;
+  const char *line = nullptr;
+  while (true) {
+    if (STATE_NEXT == state && open.empty()) {
+      return begin;
+    }
+    begin = skip_whitespace(begin, end, lines, line);
+    if (end == begin) {
+      error = "Reached end of stream whilst attempting to read value.";
+      return begin;
+    }
+    switch (state) {
+      case STATE_VALUE: {
+        switch (*begin) {
+          case '{':
+          case '[': {
+            const json::type type = '{' == *begin ? TYPE_OBJECT : TYPE_ARRAY;
+            const char close = TYPE_OBJECT == type ? '}' : ']';
+            mNodes.push_back(json::node(type, begin, 0));
+            begin = skip_whitespace(begin + 1, end, lines, line);
+            if (end != begin && close == *begin) {
+              begin++;
+              state = STATE_NEXT;
+            } else {
+              open.push_back(mNodes.size() - 1);
+              state = TYPE_OBJECT == type ? STATE_KEY : STATE_VALUE;
+            }
+            continue;
+          }
+          case '"':
+            begin = record_string(begin, end, error);
+            break;
+          case '-':
+          case '0':
+          case '1':
+          case '2':
+          case '3':
+          case '4':
+          case '5':
+          case '6':
+          case '7':
+          case '8':
+          case '9':
+            begin = record_number(begin, end, error);
+            break;
+          case 't':
+            begin = record_literal(begin, end, "true", TYPE_BOOL, error);
+            break;
+          case 'f':
+            begin = record_literal(begin, end, "false", TYPE_BOOL, error);
+            break;
+          case 'n':
+            begin = record_literal(begin, end, "null", TYPE_NULL, error);
+            break;
+          default:
+            error = "Unexpected character whilst attempting to read value.";
+            break;
+        }
+        if (error) {
+          return begin;
+        }
+        state = STATE_NEXT;
+      } break;
+      case STATE_KEY: {
+        if ('"' != *begin) {
+          error = "Unexpected character, expected '\"' to begin a key.";
+          return begin;
+        }
+        begin = record_string(begin, end, error);
+        if (error) {
+          return begin;
+        }
+        begin = skip_whitespace(begin, end, lines, line);
+        if (end == begin || ':' != *begin) {
+          error = "Unexpected character, expected ':' key value separator.";
+          return begin;
+        }
+        begin++;
+        state = STATE_VALUE;
+      } break;
+      case STATE_NEXT: {
+        const size_t index = open.back();
+        json::node &parent = mNodes[index];
+        parent.mSize++;
+        const bool object = TYPE_OBJECT == parent.mType;
+        if (',' == *begin) {
+          begin++;
+          state = object ? STATE_KEY : STATE_VALUE;
+        } else if ((object ? '}' : ']') == *begin) {
+          parent.mSkip = static_cast<uint32_t>(mNodes.size() - index - 1);
+          open.pop_back();
+          begin++;
+        } else {
+          error = object ? "Unexpected character, expected ',' or '}'."
+                         : "Unexpected character, expected ',' or ']'.";
+          return begin;
+        }
+      } break;
+    }
+  }
+}
+
+const char *json::tape::record_string(const char *begin, const char *end,
+                                      const char *&error) {
+  const char *data = begin + 1;
+  bool escaped = false;
+  for (begin = data;;) {
+    begin = validate_utf8(begin, scan_string(begin, end));
+    if (end == begin) {
+      error = "No closing '\"' string terminator before end of stream.";
+      return begin;
+    }
+    const char c = *begin;
+    if ('"' == c) {
+      break;
+    }
+    if ('\\' == c) {
+      // NOTE: Escapes are checked now but only decoded when accessed.
+      escaped = true;
+      const char *escape = begin + 1;
+      if (end == escape) {
+        error = "No closing '\"' string terminator before end of stream.";
+        return escape;
+      }
+      switch (*escape) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          begin += 2;
+          break;
+        case 'u': {
+          uint32_t code;
+          const size_t digits = read_hex(escape + 1, end, code);
+          if (4 != digits) {
+            error = "Did not find 4 hexadecimal digits.";
+            return escape + 1 + digits;
+          }
+          if (!code) {
+            error = "Found invalid UTF-8 control character.";
+            return begin;
+          }
+          begin += 6;
+        } break;
+        default:
+          error = "Found invalid control character following '\\'.";
+          return escape;
+      }
+      continue;
+    }
+    if (0x80 & c) {
+      error = "Found invalid UTF-8 sequence.";
+      return begin;
+    }
+    if ('\b' == c || '\f' == c || '\n' == c || '\r' == c) {
+      error = "Found invalid raw control character.";
+      return begin;
+    }
+    // NOTE: Other raw control characters are kept, as by json::read.
+    begin++;
+  }
+  mNodes.push_back(json::node(TYPE_STRING, data, begin - data));
+  mNodes.back().mEscaped = escaped;
+  return begin + 1;
+}
+
+const char *json::tape::record_number(const char *begin, const char *end,
+                                      const char *&error) {
+  const char *cursor = scan_number(begin, end, error);
+  if (!error) {
+    mNodes.push_back(json::node(TYPE_NUMBER, begin, cursor - begin));
+  }
+  return cursor;
+}
+
+const char *json::tape::record_literal(const char *begin, const char *end,
+                                       const char *literal, json::type type,
+                                       const char *&error) {
+  const size_t size = std::char_traits<char>::length(literal);
+  if (static_cast<size_t>(end - begin) < size ||
+      0 != std::memcmp(begin, literal, size)) {
+    error = TYPE_BOOL == type ? "Expected boolean literal 'true' or 'false'."
+                              : "Expected literal 'null'.";
+    return begin;
+  }
+  mNodes.push_back(json::node(type, begin, size));
+  return begin + size;
+}
+
+const json::node *json::node::get(const json::view &key) const {
+  // NOTE: The last entry with the key wins, as when reading a json::object.
+  const json::node *found = nullptr;
+  for (auto entry = begin(); end() != entry; ++entry) {
+    if (entry->mEscaped ? key == json::view(entry->string())
+                        : key == entry->view()) {
+      found = &entry.value();
+    }
+  }
+  return found;
+}
+
+std::string json::node::string() const {
+  if (!mEscaped) {
+    return std::string(mData, mSize);
+  }
+  // NOTE: Include the quotes, the string was checked when it was recorded so
+  // failing to decode it again is reported as the readers report errors.
+  position_t pos(mSize + 2);
+  diagnostic_t diag;
+  std::string str = read_string(mData - 1, pos, diag);
+  if (diag) {
+    fprintf(stderr, "error: %zu:%zu: %s\n", pos.line, pos.column, diag.error);
+    return {};
+  }
+  return str;
+}
+
+json::value json::node::value() const {
+  switch (mType) {
+    case TYPE_OBJECT: {
+      json::object object;
+      object.reserve(mSize);
+      for (auto entry = begin(); end() != entry; ++entry) {
+        object.add(entry->string(), entry.value().value());
+      }
+      return json::value(std::move(object));
+    }
+    case TYPE_ARRAY: {
+      json::array array;
+      array.reserve(mSize);
+      for (auto &element : *this) {
+        array.append(element.value());
+      }
+      return json::value(std::move(array));
+    }
+    case TYPE_NUMBER:
+      // NOTE: The number was checked when it was recorded.
+      return number_value(mData, mData + mSize);
+    case TYPE_STRING:
+      return json::value(string());
+    case TYPE_BOOL:
+      return json::value(boolean());
+    default:
+      return json::value();
+  }
+}
+
+/// @brief FNV-1a hash of an object key.
+inline uint32_t hash(const json::view &key) {
+  uint32_t hash = 2166136261u;
+  for (size_t index = 0; index < key.size(); index++) {
+    hash = (hash ^ static_cast<unsigned char>(key.data()[index])) * 16777619u;
+  }
+  return hash;
+}
+
+json::value &json::object::insert(std::string key, json::value value) {
+  const size_t index = find(key);
+  if (mEntries.size() != index) {
+    mEntries[index].second = std::move(value);
+    return mEntries[index].second;
+  }
+  mEntries.emplace_back(std::move(key), std::move(value));
+  if (index_threshold < mEntries.size()) {
+    if (mIndex.size() < 2 * mEntries.size()) {
+      reindex();
+    } else {
+      const uint32_t mask = static_cast<uint32_t>(mIndex.size() - 1);
+      uint32_t slot = hash(mEntries.back().first) & mask;
+      while (mIndex[slot]) {
+        slot = (slot + 1) & mask;
+      }
+      mIndex[slot] = static_cast<uint32_t>(mEntries.size());
+    }
+  }
+  return mEntries.back().second;
+}
+
+size_t json::object::find(const json::view &key) const {
+  if (mIndex.empty()) {
+    // NOTE: Small objects are searched linearly.
+    for (size_t index = 0; index < mEntries.size(); index++) {
+      if (key == mEntries[index].first) {
+        return index;
+      }
+    }
+    return mEntries.size();
+  }
+  const uint32_t mask = static_cast<uint32_t>(mIndex.size() - 1);
+  for (uint32_t slot = hash(key) & mask; mIndex[slot];
+       slot = (slot + 1) & mask) {
+    if (key == mEntries[mIndex[slot] - 1].first) {
+      return mIndex[slot] - 1;
+    }
+  }
+  return mEntries.size();
+}
+
+void json::object::reindex() {
+  // NOTE: Keep the table at most half full.
+  size_t capacity = 4 * index_threshold;
+  while (capacity < 4 * mEntries.size()) {
+    capacity *= 2;
   }
-  indent--;
-  stream << "\n";
-  push(indent, stream);
-  stream << "]";
+  mIndex.assign(capacity, 0);
+  const uint32_t mask = static_cast<uint32_t>(capacity - 1);
+  for (size_t index = 0; index < mEntries.size(); index++) {
+    uint32_t slot = hash(mEntries[index].first) & mask;
+    while (mIndex[slot]) {
+      slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = static_cast<uint32_t>(index + 1);
+  }
+}
+
+json::arena::arena(size_t block_size)
+    : mHead(nullptr),
+      mCurrent(nullptr),
+      mEnd(nullptr),
+      mBlockSize(block_size),
+      mFree(),
+      mCleanups(nullptr) {}
+
+json::arena::~arena() { release(); }
+
+/// @brief Base two logarithm of a size, rounded down.
+inline size_t floor_log2(size_t size) {
+  size_t log = 0;
+  while (size >>= 1) {
+    log++;
+  }
+  return log;
+}
+
+void *json::arena::allocate(size_t size, size_t alignment) {
+  // NOTE: All freed memory of the size class of the next power of two up
+  // holds the size.
+  if (sizeof(free_block) <= size) {
+    const size_t size_class = floor_log2(size - 1) + 1;
+    free_block *freed = size_classes > size_class ? mFree[size_class] : nullptr;
+    if (freed && 0 == reinterpret_cast<uintptr_t>(freed) % alignment) {
+      mFree[size_class] = freed->next;
+      return freed;
+    }
+  }
+  uintptr_t current = reinterpret_cast<uintptr_t>(mCurrent);
+  uintptr_t aligned = (current + alignment - 1) & ~(alignment - 1);
+  if (!mCurrent || aligned + size > reinterpret_cast<uintptr_t>(mEnd)) {
+    // NOTE: Allocations larger than a block get a block of their own.
+    const size_t header = (sizeof(block) + alignof(std::max_align_t) - 1) &
+                          ~(alignof(std::max_align_t) - 1);
+    const size_t capacity = std::max(mBlockSize, size + alignment);
+    block *next = static_cast<block *>(::operator new(header + capacity));
+    next->next = mHead;
+    mHead = next;
+    mCurrent = reinterpret_cast<char *>(next) + header;
+    mEnd = mCurrent + capacity;
+    current = reinterpret_cast<uintptr_t>(mCurrent);
+    aligned = (current + alignment - 1) & ~(alignment - 1);
+  }
+  mCurrent = reinterpret_cast<char *>(aligned + size);
+  return reinterpret_cast<void *>(aligned);
+}
+
+void json::arena::deallocate(void *pointer, size_t size) {
+  if (sizeof(free_block) <= size &&
+      0 == reinterpret_cast<uintptr_t>(pointer) % alignof(free_block)) {
+    const size_t size_class = floor_log2(size);
+    free_block *freed = new (pointer) free_block{mFree[size_class]};
+    mFree[size_class] = freed;
+  }
+}
+
+void json::arena::own(void *object, void (*destroy)(void *)) {
+  mCleanups = new (allocate(sizeof(cleanup), alignof(cleanup)))
+      cleanup{mCleanups, object, destroy};
+}
+
+void json::arena::release() {
+  for (; mCleanups; mCleanups = mCleanups->next) {
+    mCleanups->destroy(mCleanups->object);
+  }
+  std::fill(mFree, mFree + size_classes, nullptr);
+  while (mHead) {
+    block *next = mHead->next;
+    ::operator delete(mHead);
+    mHead = next;
+  }
+  mCurrent = nullptr;
+  mEnd = nullptr;
+}
+
+json::handler::~handler() {}
+
+bool json::handler::begin_object() { return true; }
+
+bool json::handler::key(std::string &) { return true; }
+
+bool json::handler::end_object() { return true; }
+
+bool json::handler::begin_array() { return true; }
+
+bool json::handler::end_array() { return true; }
+
+bool json::handler::string(std::string &) { return true; }
+
+bool json::handler::string(const json::view &string) {
+  std::string copy = string.str();
+  return this->string(copy);
 }
 
-void write_string(const std::string &string, indent_t &indent,
-                  std::stringstream &stream) {
-  stream << "\"";
-  for (auto c : string) {
-    switch (c) {
-      case '\"':
-        stream << "\\\"";
+bool json::handler::number(double) { return true; }
+
+bool json::handler::number(int64_t number) {
+  return this->number(static_cast<double>(number));
+}
+
+bool json::handler::number(uint64_t number) {
+  return this->number(static_cast<double>(number));
+}
+
+bool json::handler::boolean(bool) { return true; }
+
+bool json::handler::null() { return true; }
+
+json::parser::parser() : parser(nullptr) {}
+
+json::parser::parser(json::arena *arena)
+    : mBuilder(arena),
+      mHandler(&mBuilder),
+      mArena(arena),
+      mState(STATE_VALUE),
+      mStack(),
+      mToken(),
+      mHex(),
+      mLiteral(nullptr),
+      mKey(false),
+      mError(nullptr),
+      mLine(1),
+      mColumn(1),
+      mRemaining(0),
+      mLow(0),
+      mHigh(0) {}
+
+json::parser::parser(json::handler &handler) : parser(nullptr) {
+  mHandler = &handler;
+}
+
+bool json::parser::feed(const char *data, size_t size) {
+  for (size_t index = 0; index < size; index++) {
+    if (whitespace(data[index]) && skips_whitespace()) {
+      const char *begin = data + index;
+      size_t lines = 0;
+      const char *line = nullptr;
+      const char *end = skip_whitespace(begin, data + size, lines, line);
+      if (lines) {
+        mLine += lines;
+        mColumn = end - line + 1;
+      } else {
+        mColumn += end - begin;
+      }
+      index += end - begin;
+      if (index == size) {
         break;
-      case '\\':
-        stream << "\\\\";
+      }
+    }
+    if (STATE_STRING == mState && !mRemaining) {
+      // NOTE: Consume the run of characters which need no unescaping at once,
+      // a complete run is copied to the arena and viewed. Strings split by the
+      // end of the data are accumulated in the token, as are sequences which
+      // are completed by consume.
+      const char *begin = data + index;
+      const char *end =
+          validate_utf8(begin, scan_string(begin, data + size));
+      mColumn += end - begin;
+      index += end - begin;
+      if (mArena && !mKey && mToken.empty() && index != size &&
+          '"' == *end) {
+        mColumn++;
+        char *retained = static_cast<char *>(mArena->allocate(end - begin, 1));
+        std::memcpy(retained, begin, end - begin);
+        if (!emit(mHandler->string(json::view(retained, end - begin)))) {
+          return false;
+        }
+        continue;
+      }
+      mToken.append(begin, end);
+      if (index == size) {
         break;
-      case '/':
-        stream << "\\/";
+      }
+    }
+    if (!consume(data[index])) {
+      return false;
+    }
+    if ('\n' == data[index]) {
+      mLine++;
+      mColumn = 1;
+    } else {
+      mColumn++;
+    }
+  }
+  return true;
+}
+
+bool json::parser::feed(const std::string &string) {
+  return feed(string.data(), string.size());
+}
+
+void json::parser::reset() {
+  // NOTE: Strings retained by the arena are released with the arena.
+  mBuilder.reset();
+  mState = STATE_VALUE;
+  mStack.clear();
+  mToken.clear();
+  mHex.clear();
+  mLiteral = nullptr;
+  mKey = false;
+  mError = nullptr;
+  mLine = 1;
+  mColumn = 1;
+  mRemaining = 0;
+}
+
+bool json::parser::finish() {
+  if (STATE_NUMBER == mState && !complete_number()) {
+    return false;
+  }
+  if (STATE_ERROR == mState) {
+    return false;
+  }
+  if (STATE_DONE != mState) {
+    return fail("Reached end of stream whilst attempting to read value.");
+  }
+  return true;
+}
+
+json::value &json::parser::value() { return mBuilder.value; }
+
+const json::value &json::parser::value() const { return mBuilder.value; }
+
+const char *json::parser::error() const { return mError; }
+
+size_t json::parser::line() const { return mLine; }
+
+size_t json::parser::column() const { return mColumn; }
+
+bool json::parser::consume(const char c) {
+  switch (mState) {
+    case STATE_VALUE: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case '{':
+          return open(json::TYPE_OBJECT, mHandler->begin_object());
+        case '[':
+          return open(json::TYPE_ARRAY, mHandler->begin_array());
+        case '"':
+          mKey = false;
+          mToken.clear();
+          mState = STATE_STRING;
+          return true;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+          mToken.assign(1, c);
+          mState = STATE_NUMBER;
+          return true;
+        case 't':
+          mLiteral = "true";
+          mToken.assign(1, c);
+          mState = STATE_LITERAL;
+          return true;
+        case 'f':
+          mLiteral = "false";
+          mToken.assign(1, c);
+          mState = STATE_LITERAL;
+          return true;
+        case 'n':
+          mLiteral = "null";
+          mToken.assign(1, c);
+          mState = STATE_LITERAL;
+          return true;
+        default:
+          return fail("Unexpected character whilst attempting to read value.");
+      }
+    }
+    case STATE_OBJECT_KEY_OR_END:
+      if ('}' == c) {
+        return close(mHandler->end_object());
+      }
+      JSON_FALLTHROUGH;
+    case STATE_OBJECT_KEY: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case '"':
+          mKey = true;
+          mToken.clear();
+          mState = STATE_STRING;
+          return true;
+        default:
+          return fail("Unexpected character, expected object key string.");
+      }
+    }
+    case STATE_OBJECT_COLON: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case ':':
+          mState = STATE_VALUE;
+          return true;
+        default:
+          return fail(
+              "Unexpected character, expected ':' key value separator.");
+      }
+    }
+    case STATE_OBJECT_COMMA_OR_END: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case ',':
+          mState = STATE_OBJECT_KEY;
+          return true;
+        case '}':
+          return close(mHandler->end_object());
+        default:
+          return fail("Unexpected character whilst attempting to read object.");
+      }
+    }
+    case STATE_ARRAY_VALUE_OR_END: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case ']':
+          return close(mHandler->end_array());
+        default:
+          mState = STATE_VALUE;
+          return consume(c);
+      }
+    }
+    case STATE_ARRAY_COMMA_OR_END: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        case ',':
+          mState = STATE_VALUE;
+          return true;
+        case ']':
+          return close(mHandler->end_array());
+        default:
+          return fail("Unexpected character whilst attempting to read array.");
+      }
+    }
+    case STATE_STRING: {
+      if (mRemaining) {
+        const unsigned char byte = c;
+        if (mLow > byte || mHigh < byte) {
+          return fail("Found invalid UTF-8 sequence.");
+        }
+        mRemaining--;
+        mLow = 0x80;
+        mHigh = 0xbf;
+        mToken.push_back(c);
+        return true;
+      }
+      switch (c) {
+        case '"':  // NOTE: End of string
+          return complete_string();
+        case '\\':  // NOTE: Control character
+          mState = STATE_STRING_ESCAPE;
+          return true;
+        case '\b':
+        case '\f':
+        case '\n':
+        case '\r':  // NOTE: Invalid raw control character
+          return fail("Found invalid raw control character.");
+        default:  // NOTE: Valid normal character
+          if (0x80 & c && !utf8_lead(c, mRemaining, mLow, mHigh)) {
+            return fail("Found invalid UTF-8 sequence.");
+          }
+          mToken.push_back(c);
+          return true;
+      }
+    }
+    case STATE_STRING_ESCAPE: {
+      mState = STATE_STRING;
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          mToken.push_back(c);
+          return true;
+        case 'b':
+          mToken.push_back('\b');
+          return true;
+        case 'f':
+          mToken.push_back('\f');
+          return true;
+        case 'n':
+          mToken.push_back('\n');
+          return true;
+        case 'r':
+          mToken.push_back('\r');
+          return true;
+        case 't':
+          mToken.push_back('\t');
+          return true;
+        case 'u':
+          mHex.clear();
+          mState = STATE_STRING_UNICODE;
+          return true;
+        default:
+          return fail("Found invalid control character following '\\'.");
+      }
+    }
+    case STATE_STRING_UNICODE: {
+      if (!std::isxdigit(static_cast<unsigned char>(c))) {
+        return fail("Did not find 4 hexadecimal digits.");
+      }
+      mHex.push_back(c);
+      if (4 == mHex.size()) {
+        uint32_t code = std::strtoul(mHex.c_str(), nullptr, 16);
+        if (!code) {
+          return fail("Found invalid UTF-8 control character.");
+        }
+        append_utf8(code, mToken);
+        mState = STATE_STRING;
+      }
+      return true;
+    }
+    case STATE_NUMBER: {
+      switch (c) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '+':
+        case '-':
+        case '.':
+        case 'e':
+        case 'E':
+          mToken.push_back(c);
+          return true;
+        default:
+          // NOTE: The number ends at the first character which can not be
+          // part of it, that character is then consumed in the new state.
+          return complete_number() && consume(c);
+      }
+    }
+    case STATE_LITERAL: {
+      if (c != mLiteral[mToken.size()]) {
+        switch (mLiteral[0]) {
+          case 't':
+            return fail("Expected boolean literal 'true'.");
+          case 'f':
+            return fail("Expected boolean literal 'false'.");
+          default:
+            return fail("Expected literal 'null'.");
+        }
+      }
+      mToken.push_back(c);
+      if ('\0' == mLiteral[mToken.size()]) {
+        return complete_literal();
+      }
+      return true;
+    }
+    case STATE_DONE: {
+      switch (c) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+          return true;
+        default:
+          return fail("Unexpected character following value.");
+      }
+    }
+    case STATE_ERROR:
+      return false;
+  }
+  return fail("Unexpected parser state.");
+}
+
+bool json::parser::skips_whitespace() const {
+  switch (mState) {
+    case STATE_VALUE:
+    case STATE_OBJECT_KEY_OR_END:
+    case STATE_OBJECT_KEY:
+    case STATE_OBJECT_COLON:
+    case STATE_OBJECT_COMMA_OR_END:
+    case STATE_ARRAY_VALUE_OR_END:
+    case STATE_ARRAY_COMMA_OR_END:
+    case STATE_DONE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool json::parser::fail(const char *error) {
+  mError = error;
+  mState = STATE_ERROR;
+  return false;
+}
+
+bool json::parser::emit(bool accepted) {
+  if (!accepted) {
+    return fail("Reading was stopped by the handler.");
+  }
+  if (mStack.empty()) {
+    mState = STATE_DONE;
+  } else if (json::TYPE_OBJECT == mStack.back()) {
+    mState = STATE_OBJECT_COMMA_OR_END;
+  } else {
+    mState = STATE_ARRAY_COMMA_OR_END;
+  }
+  return true;
+}
+
+bool json::parser::open(json::type type, bool accepted) {
+  if (!accepted) {
+    return fail("Reading was stopped by the handler.");
+  }
+  mStack.push_back(type);
+  mState = json::TYPE_OBJECT == type ? STATE_OBJECT_KEY_OR_END
+                                     : STATE_ARRAY_VALUE_OR_END;
+  return true;
+}
+
+bool json::parser::close(bool accepted) {
+  mStack.pop_back();
+  return emit(accepted);
+}
+
+bool json::parser::complete_string() {
+  if (mKey) {
+    if (!mHandler->key(mToken)) {
+      return fail("Reading was stopped by the handler.");
+    }
+    mToken.clear();
+    mState = STATE_OBJECT_COLON;
+    return true;
+  }
+  bool accepted = mHandler->string(mToken);
+  mToken.clear();
+  return emit(accepted);
+}
+
+bool json::parser::complete_number() {
+  const char *begin = mToken.data();
+  const char *end = begin + mToken.size();
+  const char *error = nullptr;
+  if (end != scan_number(begin, end, error) || error) {
+    return fail(error ? error : "Invalid number.");
+  }
+  bool negative;
+  uint64_t magnitude;
+  if (parse_integer(begin, end, negative, magnitude)) {
+    if (negative) {
+      return emit(mHandler->number(negate(magnitude)));
+    }
+    return emit(mHandler->number(magnitude));
+  }
+  return emit(mHandler->number(c_strtod(mToken.c_str(), nullptr)));
+}
+
+bool json::parser::complete_literal() {
+  switch (mLiteral[0]) {
+    case 't':
+      return emit(mHandler->boolean(true));
+    case 'f':
+      return emit(mHandler->boolean(false));
+    default:
+      return emit(mHandler->null());
+  }
+}
+
+json::parser::builder::builder(json::arena *arena)
+    : value(), mArena(arena), mStack() {}
+
+bool json::parser::builder::begin_object() {
+  mStack.push_back(
+      {json::TYPE_OBJECT, json::object(mArena), json::array(mArena), {}});
+  return true;
+}
+
+bool json::parser::builder::key(std::string &key) {
+  mStack.back().key.swap(key);
+  return true;
+}
+
+bool json::parser::builder::end_object() { return close(); }
+
+bool json::parser::builder::begin_array() {
+  mStack.push_back(
+      {json::TYPE_ARRAY, json::object(mArena), json::array(mArena), {}});
+  return true;
+}
+
+bool json::parser::builder::end_array() { return close(); }
+
+bool json::parser::builder::string(std::string &string) {
+  if (mArena) {
+    // NOTE: Copy to the arena so the parser keeps the capacity of its token.
+    char *data = static_cast<char *>(mArena->allocate(string.size(), 1));
+    std::memcpy(data, string.data(), string.size());
+    return complete(json::value(json::view(data, string.size()), mArena));
+  }
+  return complete(json::value(std::move(string)));
+}
+
+bool json::parser::builder::string(const json::view &string) {
+  return complete(json::value(string, mArena));
+}
+
+bool json::parser::builder::number(double number) {
+  return complete(json::value(number));
+}
+
+bool json::parser::builder::number(int64_t number) {
+  return complete(json::value(number));
+}
+
+bool json::parser::builder::number(uint64_t number) {
+  return complete(json::value(number));
+}
+
+bool json::parser::builder::boolean(bool boolean) {
+  return complete(json::value(boolean));
+}
+
+bool json::parser::builder::null() { return complete(json::value()); }
+
+void json::parser::builder::reset() {
+  value = json::value();
+  mStack.clear();
+}
+
+bool json::parser::builder::complete(json::value value) {
+  if (mStack.empty()) {
+    this->value = std::move(value);
+    return true;
+  }
+  frame &top = mStack.back();
+  if (json::TYPE_OBJECT == top.type) {
+    top.object.add(std::move(top.key), std::move(value));
+  } else {
+    top.array.append(std::move(value));
+  }
+  return true;
+}
+
+bool json::parser::builder::close() {
+  // NOTE: The value is constructed once complete so an arena can tell whether
+  // it holds memory outside of it.
+  frame &top = mStack.back();
+  json::value value =
+      json::TYPE_OBJECT == top.type
+          ? json::value(std::move(top.object), mArena)
+          : json::value(std::move(top.array), mArena);
+  mStack.pop_back();
+  return complete(std::move(value));
+}
+
+void write_value(const json::value &value, output_t &out);
+
+void write_string(const json::view &string, output_t &out) {
+  static const char hex[] = "0123456789abcdef";
+  out.put('"');
+  const char *begin = string.data();
+  const char *end = begin + string.size();
+  while (begin != end) {
+    // NOTE: Copy the run of characters which need no escaping at once.
+    const char *special = scan_string(begin, end);
+    out.put(begin, special - begin);
+    if (special == end) {
+      break;
+    }
+    switch (*special) {
+      case '"':
+        out.put("\\\"", 2);
+        break;
+      case '\\':
+        out.put("\\\\", 2);
         break;
       case '\b':
-        stream << "\\b";
+        out.put("\\b", 2);
         break;
       case '\f':
-        stream << "\\f";
+        out.put("\\f", 2);
         break;
       case '\n':
-        stream << "\\n";
+        out.put("\\n", 2);
         break;
       case '\r':
-        stream << "\\r";
+        out.put("\\r", 2);
         break;
       case '\t':
-        stream << "\\t";
-        break;
-      default:
-        stream << c;
+        out.put("\\t", 2);
         break;
+      default: {
+        const unsigned char c = *special;
+        const char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+        out.put(escape, sizeof(escape));
+      } break;
     }
+    begin = special + 1;
   }
-  stream << "\"";
+  out.put('"');
 }
 
-void write_value(const json::value &value, indent_t &indent,
-                 std::stringstream &stream) {
+void write_number(const json::value &value, output_t &out) {
+  char digits[32];
+  if (value.integer()) {
+    // NOTE: Format integers exactly, from the least significant digit.
+    const bool negative = 0 > value.number();
+    uint64_t magnitude = value.number<uint64_t>();
+    if (negative) {
+      magnitude = 0 - static_cast<uint64_t>(value.number<int64_t>());
+    }
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+    do {
+      *--begin = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude);
+    if (negative) {
+      *--begin = '-';
+    }
+    out.put(begin, end - begin);
+    return;
+  }
+  const double number = value.number();
+  if (!std::isfinite(number)) {
+    // NOTE: JSON has no representation of NaN or infinity.
+    out.put("null", 4);
+    return;
+  }
+  // NOTE: Use the fewest significant digits which read back exactly, always
+  // with a '.' whatever the decimal point of the current locale.
+  const char point = *std::localeconv()->decimal_point;
+  int size = 0;
+  for (int precision = 15; precision <= 17; precision++) {
+    size = snprintf(digits, sizeof(digits), "%.*g", precision, number);
+    if ('.' != point) {
+      std::replace(digits, digits + size, point, '.');
+    }
+    if (17 == precision || c_strtod(digits, nullptr) == number) {
+      break;
+    }
+  }
+  out.put(digits, size);
+}
+
+void write_object(const json::object &object, output_t &out) {
+  out.put('{');
+  out.depth++;
+  bool first = true;
+  for (auto &pair : object) {
+    if (!first) {
+      out.put(',');
+    }
+    out.newline();
+    write_string(pair.first, out);
+    if (out.tab) {
+      out.put(": ", 2);
+    } else {
+      out.put(':');
+    }
+    write_value(pair.second, out);
+    first = false;
+  }
+  out.depth--;
+  out.newline();
+  out.put('}');
+}
+
+void write_array(const json::array &array, output_t &out) {
+  out.put('[');
+  out.depth++;
+  bool first = true;
+  for (auto &value : array) {
+    if (!first) {
+      out.put(',');
+    }
+    out.newline();
+    write_value(value, out);
+    first = false;
+  }
+  out.depth--;
+  out.newline();
+  out.put(']');
+}
+
+void write_value(const json::value &value, output_t &out) {
   switch (value.type()) {
     case json::TYPE_OBJECT:
-      write_object(value.object(), indent, stream);
+      write_object(value.object(), out);
       break;
     case json::TYPE_ARRAY:
-      write_array(value.array(), indent, stream);
+      write_array(value.array(), out);
       break;
     case json::TYPE_NUMBER:
-      stream << std::setprecision(16) << value.number();
+      write_number(value, out);
       break;
     case json::TYPE_STRING:
-      write_string(value.string(), indent, stream);
+      write_string(value.view(), out);
       break;
     case json::TYPE_BOOL:
-      stream << (value.boolean() ? "true" : "false");
+      if (value.boolean()) {
+        out.put("true", 4);
+      } else {
+        out.put("false", 5);
+      }
       break;
     case json::TYPE_NULL:
-      stream << "null";
+      out.put("null", 4);
       break;
   }
+  out.spill();
 }
 
 std::string json::write(const json::value &value, const char *tab) {
-  indent_t indent(tab);
-  std::stringstream stream;
-  write_value(value, indent, stream);
-  return stream.str();
+  std::string buffer;
+  json::write(value, buffer, tab);
+  return buffer;
+}
+
+void json::write(const json::value &value, std::string &buffer,
+                 const char *tab) {
+  output_t out(buffer, nullptr, tab);
+  write_value(value, out);
+}
+
+bool json::write(const json::value &value, FILE *file, const char *tab) {
+  std::string buffer;
+  output_t out(buffer, file, tab);
+  write_value(value, out);
+  out.flush();
+  return !out.failed;
+}
+
+json::writer::writer(FILE *file, const char *tab)
+    : mBuffer(),
+      mFile(file),
+      mTab(tab),
+      mEmpty(),
+      mKey(false),
+      mFailed(false) {}
+
+json::writer::~writer() { flush(); }
+
+bool json::writer::begin_object() {
+  separate();
+  mBuffer.push_back('{');
+  mEmpty.push_back(true);
+  return true;
+}
+
+bool json::writer::key(std::string &key) {
+  separate();
+  output_t out(mBuffer, nullptr, mTab);
+  write_string(key, out);
+  if (mTab) {
+    out.put(": ", 2);
+  } else {
+    out.put(':');
+  }
+  mKey = true;
+  return true;
+}
+
+bool json::writer::end_object() {
+  mEmpty.pop_back();
+  output_t out(mBuffer, mFile, mTab);
+  out.depth = mEmpty.size();
+  out.newline();
+  out.put('}');
+  out.spill();
+  mFailed |= out.failed;
+  return !mFailed;
+}
+
+bool json::writer::begin_array() {
+  separate();
+  mBuffer.push_back('[');
+  mEmpty.push_back(true);
+  return true;
+}
+
+bool json::writer::end_array() {
+  mEmpty.pop_back();
+  output_t out(mBuffer, mFile, mTab);
+  out.depth = mEmpty.size();
+  out.newline();
+  out.put(']');
+  out.spill();
+  mFailed |= out.failed;
+  return !mFailed;
+}
+
+bool json::writer::string(std::string &string) {
+  return this->string(json::view(string));
+}
+
+bool json::writer::string(const json::view &string) {
+  separate();
+  output_t out(mBuffer, mFile, mTab);
+  write_string(string, out);
+  out.spill();
+  mFailed |= out.failed;
+  return !mFailed;
+}
+
+bool json::writer::number(double number) {
+  return write(json::value(number));
+}
+
+bool json::writer::number(int64_t number) {
+  return write(json::value(number));
+}
+
+bool json::writer::number(uint64_t number) {
+  return write(json::value(number));
+}
+
+bool json::writer::boolean(bool boolean) {
+  return write(json::value(boolean));
+}
+
+bool json::writer::null() { return write(json::value()); }
+
+bool json::writer::flush() {
+  output_t out(mBuffer, mFile, mTab);
+  out.flush();
+  mFailed |= out.failed;
+  return !mFailed;
+}
+
+bool json::writer::write(const json::value &value) {
+  separate();
+  output_t out(mBuffer, mFile, mTab);
+  write_value(value, out);
+  mFailed |= out.failed;
+  return !mFailed;
+}
+
+void json::writer::separate() {
+  // NOTE: The value of a key follows it on the same line.
+  if (mKey) {
+    mKey = false;
+    return;
+  }
+  if (mEmpty.empty()) {
+    return;
+  }
+  if (!mEmpty.back()) {
+    mBuffer.push_back(',');
+  }
+  mEmpty.back() = false;
+  output_t out(mBuffer, nullptr, mTab);
+  out.depth = mEmpty.size();
+  out.newline();
 }
@@ -0,0 +1,207 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// NOTE: Counts every allocation made through the global heap.
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+/// @brief Number of values in a tree, including the root.
+size_t count(const json::value &value) {
+  size_t nodes = 1;
+  switch (value.type()) {
+    case json::TYPE_OBJECT:
+      for (auto &pair : value.object()) {
+        nodes += count(pair.second);
+      }
+      break;
+    case json::TYPE_ARRAY:
+      for (auto &entry : value.array()) {
+        nodes += count(entry);
+      }
+      break;
+    default:
+      break;
+  }
+  return nodes;
+}
+
+/// @brief Objects nested depth levels deep, each with a key and a string.
+std::string nested(size_t depth) {
+  std::string str;
+  for (size_t level = 0; level < depth; level++) {
+    str += "{\"name\":\"level\",\"child\":";
+  }
+  str += "[1,2,3]";
+  str.append(depth, '}');
+  return str;
+}
+
+// NOTE: Each node may cost a payload, its container storage and a key but
+// never a copy per enclosing level.
+const size_t allocations_per_node = 4;
+
+int failures = 0;
+
+void check(const char *name, size_t nodes, size_t count) {
+  const bool pass = count <= allocations_per_node * nodes;
+  printf("%s: %s %zu allocations for %zu nodes\n", pass ? "PASS" : "FAIL",
+         name, count, nodes);
+  if (!pass) {
+    failures++;
+  }
+}
+
+void check_at_most(const char *name, size_t count, size_t bound) {
+  const bool pass = count <= bound;
+  printf("%s: %s %zu allocations, at most %zu\n", pass ? "PASS" : "FAIL", name,
+         count, bound);
+  if (!pass) {
+    failures++;
+  }
+}
+
+/// @brief Memory freed by a vector growing in an arena is reused by the next
+/// vector growing in it.
+void test_arena_reuse() {
+  // NOTE: Small blocks so growth which is not reused needs more of them.
+  json::arena arena(1024);
+  json::allocator<int64_t> allocator(&arena);
+  std::vector<int64_t, json::allocator<int64_t>> first(allocator);
+  for (int64_t index = 0; index < 1000; index++) {
+    first.push_back(index);
+  }
+  const size_t before = allocations;
+  std::vector<int64_t, json::allocator<int64_t>> second(allocator);
+  for (int64_t index = 0; index < 500; index++) {
+    second.push_back(index);
+  }
+  check_at_most("arena reuse", allocations - before, 0);
+
+  void *freed = arena.allocate(64, 8);
+  arena.deallocate(freed, 64);
+  const bool pass = freed == arena.allocate(48, 8);
+  printf("%s: arena reuse freed memory of the size class\n",
+         pass ? "PASS" : "FAIL");
+  if (!pass) {
+    failures++;
+  }
+}
+
+/// @brief Strings read into a document are stored in its arena, keys too
+/// long to be stored within a std::string are not.
+void test_arena_strings() {
+  std::string str = "[";
+  for (size_t index = 0; index < 100; index++) {
+    str += index ? ",\"" : "\"";
+    str += std::string(64, 'a') + "\\n" + std::to_string(index) + "\"";
+  }
+  str += "]";
+
+  json::document document;
+  size_t before = allocations;
+  json::parser parser(&document.arena());
+  parser.feed(str);
+  parser.finish();
+  check_at_most("arena strings", allocations - before, 8);
+
+  // NOTE: Strings materialized through const accessors, long keys and values
+  // added from the heap are released along with the document, the leak
+  // checker reports any which are not.
+  const json::value &root = parser.value();
+  const bool read = json::TYPE_ARRAY == root.type() &&
+                    100 == root.array().size() &&
+                    std::string(64, 'a') + "\n99" == root.array()[99].string();
+  json::document keys;
+  const json::value &object = json::read(
+      "{\"a key longer than a std::string holds\": \"value\", "
+      "\"list\": [\"an escaped string \\\" longer than that\"]}",
+      keys);
+  json::read("{\"list\": []}", document);
+  document.root().object().get("list")->array().append(
+      json::value(std::string(64, 'b')));
+  const json::value &added = document.root().object().get("list")->array()[0];
+  const bool pass = read && 2 == object.object().size() &&
+                    std::string(64, 'b') == added.string();
+  printf("%s: arena values read back\n", pass ? "PASS" : "FAIL");
+  if (!pass) {
+    failures++;
+  }
+}
+
+int main() {
+  test_arena_reuse();
+  test_arena_strings();
+
+  for (size_t depth : {16, 256}) {
+    const std::string str = nested(depth);
+
+    size_t before = allocations;
+    json::value value = json::read(str);
+    check("read", count(value), allocations - before);
+
+    json::parser parser;
+    before = allocations;
+    parser.feed(str);
+    parser.finish();
+    check("parser", count(parser.value()), allocations - before);
+
+    before = allocations;
+    json::value root = json::value(json::array{});
+    for (size_t level = 0; level < depth; level++) {
+      json::object object;
+      object.emplace("name", "level");
+      object.add("child", std::move(root));
+      root = json::value(std::move(object));
+    }
+    check("build", count(root), allocations - before);
+
+    before = allocations;
+    json::value moved = std::move(root);
+    check("move", count(moved), allocations - before);
+  }
+
+  // NOTE: Values read into a document are allocated from its arena.
+  const std::string str = nested(256);
+  json::document document;
+  json::read(str, document);
+  const size_t before = allocations;
+  json::parser parser(&document.arena());
+  parser.feed(str);
+  parser.finish();
+  check("arena", count(parser.value()), allocations - before);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// NOTE: Files are mapped into memory where supported, the reader relies on
+// the mapping being null terminated. Files which end exactly on a page
+// boundary are read for the common page sizes.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+const char *const path = "file_test.json";
+
+/// @brief Replace the test file with the given contents.
+bool write_file(const std::string &str) {
+  FILE *file = std::fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  const bool written = str.size() == std::fwrite(str.data(), 1, str.size(),
+                                                 file);
+  return 0 == std::fclose(file) && written;
+}
+
+// Counts the numbers of a document.
+class count_handler : public json::handler {
+ public:
+  count_handler() : count(0) {}
+
+  bool number(double) override {
+    count++;
+    return true;
+  }
+  bool number(int64_t) override {
+    count++;
+    return true;
+  }
+  bool number(uint64_t) override {
+    count++;
+    return true;
+  }
+
+  size_t count;
+};
+
+/// @brief An empty file is not a document.
+void test_empty() {
+  check(write_file(""), "write", "empty");
+  check(json::TYPE_NULL == json::read_file(path, false).type(), "empty",
+        "value");
+  count_handler handler;
+  check(!json::read_file(path, handler, false), "empty", "handler");
+}
+
+/// @brief A document filling whole pages, ending with a number whose end is
+/// only found at the end of the file.
+void test_pages() {
+  for (size_t page : {4096, 16384, 65536}) {
+    for (size_t pages : {1, 2}) {
+      const size_t size = page * pages;
+      std::string str = "[";
+      size_t numbers = 0;
+      while (str.size() + 16 < size) {
+        str += "12345678,";
+        numbers++;
+      }
+      // NOTE: Pad the last number with leading whitespace to fill the pages.
+      str += std::string(size - str.size() - 2, ' ') + "7]";
+      numbers++;
+      const std::string detail = std::to_string(size) + " bytes";
+      check(size == str.size() && write_file(str), "write", detail);
+
+      json::value value = json::read_file(path, false);
+      check(json::TYPE_ARRAY == value.type() &&
+                numbers == value.array().size() &&
+                7 == value.array()[numbers - 1].number(),
+            "pages", detail);
+
+      count_handler handler;
+      check(json::read_file(path, handler, false) &&
+                numbers == handler.count,
+            "pages handler", detail);
+
+      // NOTE: A scalar ending at the end of the last page.
+      str.assign(size - 1, ' ');
+      str += "5";
+      check(write_file(str) &&
+                5 == json::read_file(path, false).number<int>(),
+            "scalar", detail);
+    }
+  }
+}
+
+/// @brief A file which does not exist can not be read.
+void test_missing() {
+  std::remove(path);
+  check(json::TYPE_NULL == json::read_file(path, false).type(), "missing",
+        "value");
+  count_handler handler;
+  check(!json::read_file(path, handler, false) && 0 == handler.count,
+        "missing", "handler");
+  check(json::TYPE_NULL == json::read_file(".", false).type(), "directory",
+        "value");
+}
+
+int main() {
+  test_empty();
+  test_pages();
+  test_missing();
+  std::remove(path);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Records each event as a token so sequences of events can be compared.
+class recorder : public json::handler {
+ public:
+  recorder() : events(), stop(nullptr) {}
+
+  bool begin_object() override { return event("{"); }
+  bool key(std::string &key) override { return event("k:" + key); }
+  bool end_object() override { return event("}"); }
+  bool begin_array() override { return event("["); }
+  bool end_array() override { return event("]"); }
+  bool string(std::string &string) override { return event("s:" + string); }
+  bool number(double number) override {
+    char str[32];
+    snprintf(str, sizeof(str), "d:%g", number);
+    return event(str);
+  }
+  bool number(int64_t number) override {
+    char str[32];
+    snprintf(str, sizeof(str), "i:%" PRId64, number);
+    return event(str);
+  }
+  bool number(uint64_t number) override {
+    char str[32];
+    snprintf(str, sizeof(str), "u:%" PRIu64, number);
+    return event(str);
+  }
+  bool boolean(bool boolean) override {
+    return event(boolean ? "true" : "false");
+  }
+  bool null() override { return event("null"); }
+
+  std::string events;
+  // NOTE: When not null, stop reading at the event with this token.
+  const char *stop;
+
+ private:
+  bool event(const std::string &token) {
+    events += token;
+    events += ' ';
+    return !stop || token != stop;
+  }
+};
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+/// @brief Feed a document to a parser in chunks of the given size.
+///
+/// @return Returns false if feeding or finishing failed.
+bool feed(json::parser &parser, const std::string &str, size_t chunk) {
+  for (size_t offset = 0; offset < str.size(); offset += chunk) {
+    if (!parser.feed(str.data() + offset,
+                     std::min(chunk, str.size() - offset))) {
+      return false;
+    }
+  }
+  return parser.finish();
+}
+
+const char *const document =
+    "{\n"
+    "  \"id\": 42,\n"
+    "  \"name\": \"caf\xc3\xa9 \\\"bar\\\" \\u00e9\\n\",\n"
+    "  \"ratio\": -1.5e3,\n"
+    "  \"big\": 18446744073709551615,\n"
+    "  \"small\": -9223372036854775808,\n"
+    "  \"flags\": [true, false, null, []],\n"
+    "  \"nested\": {\"empty\": {}}\n"
+    "}\n";
+
+const char *const events =
+    "{ k:id u:42 k:name s:caf\xc3\xa9 \"bar\" \xc3\xa9\n k:ratio d:-1500 "
+    "k:big u:18446744073709551615 k:small i:-9223372036854775808 "
+    "k:flags [ true false null [ ] ] k:nested { k:empty { } } } ";
+
+/// @brief Events are the same however the document is split into chunks.
+void test_chunks() {
+  const std::string str = document;
+  for (size_t chunk = 1; chunk <= str.size(); chunk++) {
+    recorder handler;
+    json::parser parser(handler);
+    const bool success = feed(parser, str, chunk);
+    if (!success || events != handler.events) {
+      check(false, "chunks", std::to_string(chunk) + ": " + handler.events);
+      return;
+    }
+  }
+  check(true, "chunks", "events match for every chunk size");
+
+  recorder handler;
+  check(json::read(str, handler) && events == handler.events, "read",
+        handler.events);
+}
+
+struct error_case {
+  const char *str;
+  const char *error;
+  size_t line;
+  size_t column;
+};
+
+/// @brief Errors are reported at the same position however the document is
+/// split, including errors in tokens split between chunks.
+void test_errors() {
+  const error_case cases[] = {
+      {"[tru", "Reached end of stream whilst attempting to read value.", 1, 5},
+      {"[trux]", "Expected boolean literal 'true'.", 1, 5},
+      {"{\"a\" 1}", "Unexpected character, expected ':' key value separator.",
+       1, 6},
+      {"{\"a\":\n  nul}", "Expected literal 'null'.", 2, 6},
+      {"[\"\\u00zz\"]", "Did not find 4 hexadecimal digits.", 1, 7},
+      {"[\"\\q\"]", "Found invalid control character following '\\'.", 1, 4},
+      {"[\"\xc3\x28\"]", "Found invalid UTF-8 sequence.", 1, 4},
+      {"[\"\xe2\x82\"]", "Found invalid UTF-8 sequence.", 1, 5},
+      {"[1.2.3]", "Invalid number.", 1, 7},
+      {"[1] x", "Unexpected character following value.", 1, 5},
+      {"{\"a\": [1, 2}", "Unexpected character whilst attempting to read "
+                         "array.", 1, 12},
+  };
+  for (auto &error : cases) {
+    const std::string str = error.str;
+    bool pass = true;
+    std::string detail = str;
+    for (size_t chunk = 1; pass && chunk <= str.size(); chunk++) {
+      recorder handler;
+      json::parser parser(handler);
+      pass = !feed(parser, str, chunk) && parser.error() &&
+             !strcmp(error.error, parser.error()) &&
+             error.line == parser.line() && error.column == parser.column();
+      if (!pass) {
+        detail += " chunk " + std::to_string(chunk) + ": " +
+                  std::to_string(parser.line()) + ":" +
+                  std::to_string(parser.column()) + ": " +
+                  (parser.error() ? parser.error() : "no error");
+      }
+    }
+    check(pass, "error", detail);
+  }
+}
+
+/// @brief A number is only complete once the character following it, or the
+/// end of the stream, is seen.
+void test_numbers() {
+  recorder handler;
+  json::parser parser(handler);
+  const bool success =
+      parser.feed("12") && parser.feed("34") && parser.finish();
+  check(success && "u:1234 " == handler.events, "number", handler.events);
+}
+
+/// @brief Returning false from an event stops reading.
+void test_stop() {
+  recorder handler;
+  handler.stop = "k:name";
+  json::parser parser(handler);
+  const bool success = feed(parser, document, 7);
+  check(!success && "{ k:id u:42 k:name " == handler.events &&
+            !strcmp("Reading was stopped by the handler.", parser.error()),
+        "stop", handler.events);
+
+  // NOTE: Once failed, further data is rejected.
+  check(!parser.feed("{}") && !parser.finish(), "stopped", "feed rejected");
+}
+
+/// @brief A parser reads another document once reset.
+void test_reset() {
+  json::parser parser;
+  bool success = parser.feed("[1, ") && !parser.feed("}");
+  parser.reset();
+  success = success && parser.feed("{\"a\": [1, \"b\"]}") && parser.finish();
+  check(success && "{\"a\":[1,\"b\"]}" ==
+                       json::write(parser.value(), json::compact),
+        "reset", json::write(parser.value(), json::compact));
+}
+
+int main() {
+  test_chunks();
+  test_errors();
+  test_numbers();
+  test_stop();
+  test_reset();
+  return failures ? 1 : 0;
+}
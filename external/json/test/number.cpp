@@ -0,0 +1,195 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <clocale>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+enum number_kind { SIGNED, UNSIGNED, REAL };
+
+struct number {
+  const char *str;
+  number_kind kind;
+  int64_t integer;
+  uint64_t unsigned_integer;
+  double real;
+};
+
+/// @brief Check a value read from a number has the expected kind and value.
+bool matches(const json::value &value, const number &number) {
+  if (json::TYPE_NUMBER != value.type()) {
+    return false;
+  }
+  switch (number.kind) {
+    case SIGNED:
+      return value.integer() &&
+             number.integer == value.number<int64_t>();
+    case UNSIGNED:
+      return value.integer() &&
+             number.unsigned_integer == value.number<uint64_t>();
+    default:
+      return !value.integer() && number.real == value.number();
+  }
+}
+
+// Reports the kind of the number event of a parser.
+class kind_handler : public json::handler {
+ public:
+  kind_handler() : value() {}
+
+  bool number(double number) override {
+    value = json::value(number);
+    return true;
+  }
+  bool number(int64_t number) override {
+    value = json::value(number);
+    return true;
+  }
+  bool number(uint64_t number) override {
+    value = json::value(number);
+    return true;
+  }
+
+  json::value value;
+};
+
+const int64_t int64_min = std::numeric_limits<int64_t>::min();
+const int64_t int64_max = std::numeric_limits<int64_t>::max();
+const uint64_t uint64_max = std::numeric_limits<uint64_t>::max();
+
+const number numbers[] = {
+    {"0", UNSIGNED, 0, 0, 0},
+    {"-0", SIGNED, 0, 0, 0},
+    {"42", UNSIGNED, 0, 42, 0},
+    {"-42", SIGNED, -42, 0, 0},
+    {"9223372036854775807", UNSIGNED, 0, uint64_t(int64_max), 0},
+    {"9223372036854775808", UNSIGNED, 0, uint64_t(int64_max) + 1, 0},
+    {"-9223372036854775808", SIGNED, int64_min, 0, 0},
+    {"18446744073709551615", UNSIGNED, 0, uint64_max, 0},
+    // NOTE: Integers which do not fit in 64 bits fall back to a double.
+    {"18446744073709551616", REAL, 0, 0, 18446744073709551616.0},
+    {"-9223372036854775809", REAL, 0, 0, -9223372036854775809.0},
+    {"100000000000000000000000", REAL, 0, 0, 1e23},
+    {"0.1", REAL, 0, 0, 0.1},
+    {"-1.5e3", REAL, 0, 0, -1500},
+    {"1E+2", REAL, 0, 0, 100},
+    {"2.5e-1", REAL, 0, 0, 0.25},
+    {"1.7976931348623157e308", REAL, 0, 0, 1.7976931348623157e308},
+    {"4.9406564584124654e-324", REAL, 0, 0, 4.9406564584124654e-324},
+};
+
+/// @brief Every reader reads a number to the same kind and value.
+void test_numbers() {
+  for (auto &number : numbers) {
+    const std::string str = number.str;
+    check(matches(json::read(str), number), "read", str);
+
+    json::document document;
+    check(matches(json::read(str, document), number), "document", str);
+
+    json::parser parser;
+    check(parser.feed(str) && parser.finish() &&
+              matches(parser.value(), number),
+          "parser", str);
+
+    kind_handler handler;
+    check(json::read(str, handler) && matches(handler.value, number),
+          "handler", str);
+
+    json::tape tape;
+    check(json::read(str, tape) && matches(tape.root().value(), number),
+          "tape", str);
+
+    // NOTE: Integers are written exactly.
+    if (REAL != number.kind) {
+      check(str == json::write(json::read(str)) || "-0" == str, "write",
+            json::write(json::read(str)));
+    }
+  }
+}
+
+/// @brief Every reader rejects the same malformed numbers.
+void test_invalid() {
+  const char *const invalid[] = {"1.",   "1.e5",  "01",  "-01",  "-",
+                                 "1e",   "1e+",   ".5",  "+1",   "1.5.2",
+                                 "--1",  "1e5.5", "1-2", "[1.]", "[01]",
+                                 "{\"a\": 1e}"};
+  for (const char *str : invalid) {
+    json::value value = json::read(str, false);
+    const bool read = json::TYPE_NUMBER == value.type() ||
+                      (json::TYPE_ARRAY == value.type() &&
+                       value.array().size()) ||
+                      (json::TYPE_OBJECT == value.type() &&
+                       value.object().size());
+
+    json::parser parser;
+    const bool parsed = parser.feed(str) && parser.finish();
+
+    json::tape tape;
+    const bool recorded = json::read(str, tape, false);
+
+    check(!read && !parsed && !recorded, "invalid",
+          std::string(str) + ": " + (parser.error() ? parser.error() : ""));
+  }
+}
+
+/// @brief Numbers are read and written with a '.' whatever the locale.
+void test_locale() {
+  const char *const locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8",
+                                 "fr_FR.utf8", "de_DE", "fr_FR"};
+  const char *found = nullptr;
+  for (const char *locale : locales) {
+    if (std::setlocale(LC_NUMERIC, locale)) {
+      found = locale;
+      break;
+    }
+  }
+  if (!found) {
+    printf("SKIP: locale no locale with a ',' decimal point\n");
+    return;
+  }
+  json::parser parser;
+  json::tape tape;
+  check(1.5 == json::read("1.5").number() && parser.feed("1.5") &&
+            parser.finish() && 1.5 == parser.value().number() &&
+            json::read("1.5", tape) && 1.5 == tape.root().number() &&
+            "1.5" == json::write(json::value(1.5)),
+        "locale", found);
+  std::setlocale(LC_NUMERIC, "C");
+}
+
+int main() {
+  test_numbers();
+  test_invalid();
+  test_locale();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+std::string key(size_t index) { return "key" + std::to_string(index); }
+
+/// @brief Every key is found, in order, and no other.
+bool complete(const json::object &object, size_t size, size_t offset) {
+  if (size != object.size()) {
+    return false;
+  }
+  size_t index = 0;
+  for (auto &pair : object) {
+    if (key(index) != pair.first ||
+        index + offset != pair.second.number<size_t>()) {
+      return false;
+    }
+    index++;
+  }
+  for (index = 0; index < size; index++) {
+    const json::value *value = object.get(key(index).c_str());
+    if (!value || index + offset != value->number<size_t>()) {
+      return false;
+    }
+  }
+  return !object.get(key(size).c_str()) && !object.get("") &&
+         !object.get("key");
+}
+
+/// @brief Objects small enough to search linearly and large enough to be
+/// indexed find every key and keep insertion order.
+void test_lookup() {
+  json::arena arena;
+  for (json::arena *pool : {static_cast<json::arena *>(nullptr), &arena}) {
+    const char *name = pool ? "arena" : "heap";
+    for (size_t size : {0, 1, 15, 16, 17, 33, 64, 65, 1000}) {
+      json::object object(pool);
+      for (size_t index = 0; index < size; index++) {
+        object.add(key(index), json::value(index));
+      }
+      check(complete(object, size, 0), name,
+            "lookup " + std::to_string(size));
+
+      // NOTE: Adding an existing key replaces the value in place.
+      for (size_t index = 0; index < size; index++) {
+        object.add(key(index), json::value(index + 1));
+      }
+      check(complete(object, size, 1), name,
+            "replace " + std::to_string(size));
+
+      // NOTE: Copies and moves keep the index.
+      json::object copy = object;
+      json::object moved = std::move(copy);
+      check(complete(moved, size, 1), name, "copy " + std::to_string(size));
+    }
+  }
+}
+
+/// @brief Keys are compared by their characters, not their terminator.
+void test_view() {
+  json::object object{{"alpha", json::value(1)}, {"al", json::value(2)}};
+  const char *const chars = "alphabet";
+  check(object.get(json::view(chars, 5)) &&
+            1 == object.get(json::view(chars, 5))->number() &&
+            object.get(json::view(chars, 2)) &&
+            2 == object.get(json::view(chars, 2))->number() &&
+            !object.get(json::view(chars, 3)),
+        "view", "keys matched by length");
+}
+
+/// @brief Entries of initializer lists and documents keep their order, the
+/// last value of a repeated key wins at the position of the first.
+void test_order() {
+  json::object object{{"z", json::value(1)},
+                      {"a", json::value(2)},
+                      {"z", json::value(3)}};
+  check("{\"z\":3,\"a\":2}" == json::write(json::value(object), json::compact),
+        "initializer", json::write(json::value(object), json::compact));
+
+  const std::string str = "{\"z\": 1, \"m\": [], \"a\": 2, \"z\": 3}";
+  const std::string expected = "{\"z\":3,\"m\":[],\"a\":2}";
+  check(expected == json::write(json::read(str), json::compact), "read",
+        json::write(json::read(str), json::compact));
+
+  json::document document;
+  check(expected == json::write(json::read(str, document), json::compact),
+        "document", json::write(document.root(), json::compact));
+
+  json::parser parser;
+  check(parser.feed(str) && parser.finish() &&
+            expected == json::write(parser.value(), json::compact),
+        "parser", json::write(parser.value(), json::compact));
+
+  json::tape tape;
+  check(json::read(str, tape) &&
+            expected == json::write(tape.root().value(), json::compact) &&
+            3 == tape.root().get("z")->number(),
+        "tape", json::write(tape.root().value(), json::compact));
+}
+
+/// @brief Emplace constructs the value in place and returns it.
+void test_emplace() {
+  json::object object;
+  json::value &value = object.emplace("list", json::array{});
+  value.array().append(json::value(1));
+  object.emplace("name", "value");
+  check("{\"list\":[1],\"name\":\"value\"}" ==
+            json::write(json::value(object), json::compact),
+        "emplace", json::write(json::value(object), json::compact));
+}
+
+int main() {
+  test_lookup();
+  test_view();
+  test_order();
+  test_emplace();
+  return failures ? 1 : 0;
+}
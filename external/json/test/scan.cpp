@@ -0,0 +1,209 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// NOTE: The whitespace and string scans of the readers use SSE2 or, when
+// built with JSON_AVX2, AVX2 kernels over 16 or 32 byte blocks followed by a
+// scalar tail. Special bytes are placed at every offset of runs spanning
+// several blocks and the results compared with a scalar reference.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int failures = 0;
+int checks = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  checks++;
+  if (!pass) {
+    printf("FAIL: %s %s\n", name, detail.c_str());
+    failures++;
+  }
+}
+
+// NOTE: Longer than two AVX2 blocks so every offset is tested in a block and
+// in the scalar tail.
+const size_t longest = 80;
+
+/// @brief Printable form of a document for failure messages.
+std::string escape(const std::string &str) {
+  std::string escaped;
+  for (unsigned char c : str) {
+    if (0x20 > c || 0x7f <= c) {
+      char hex[8];
+      snprintf(hex, sizeof(hex), "\\x%02x", c);
+      escaped += hex;
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+struct outcome {
+  // NOTE: Null when the document is valid.
+  const char *error;
+  size_t line;
+  size_t column;
+  std::string string;
+};
+
+/// @brief Read a document with the parser, optionally with an arena.
+outcome parse(const std::string &str, json::arena *arena) {
+  json::parser parser(arena);
+  outcome result{nullptr, 0, 0, {}};
+  if (!parser.feed(str) || !parser.finish()) {
+    result.error = parser.error();
+    result.line = parser.line();
+    result.column = parser.column();
+  } else if (json::TYPE_STRING == parser.value().type()) {
+    result.string = parser.value().string();
+  }
+  return result;
+}
+
+struct special {
+  const char *name;
+  // NOTE: Placed in the source.
+  const char *bytes;
+  // NOTE: The decoded string, or null if the string is invalid.
+  const char *decoded;
+  const char *error;
+};
+
+const special specials[] = {
+    {"control", "\x01", "\x01", nullptr},
+    {"unit separator", "\x1f", "\x1f", nullptr},
+    {"tab", "\t", "\t", nullptr},
+    {"space", " ", " ", nullptr},
+    {"delete", "\x7f", "\x7f", nullptr},
+    {"escape", "\\n", "\n", nullptr},
+    {"solidus", "\\\\", "\\", nullptr},
+    {"two byte", "\xc3\xa9", "\xc3\xa9", nullptr},
+    {"three byte", "\xe2\x82\xac", "\xe2\x82\xac", nullptr},
+    {"four byte", "\xf0\x9f\x98\x80", "\xf0\x9f\x98\x80", nullptr},
+    {"newline", "\n", nullptr, "Found invalid raw control character."},
+    {"carriage return", "\r", nullptr, "Found invalid raw control character."},
+    {"continuation", "\x80", nullptr, "Found invalid UTF-8 sequence."},
+    {"invalid", "\xff", nullptr, "Found invalid UTF-8 sequence."},
+    {"overlong", "\xc0\xaf", nullptr, "Found invalid UTF-8 sequence."},
+};
+
+/// @brief A special byte at every offset of a string of every length.
+void test_strings() {
+  for (auto &special : specials) {
+    for (size_t size = 1; size <= longest; size++) {
+      for (size_t offset = 0; offset < size; offset++) {
+        const std::string before(offset, 'a');
+        const std::string after(size - offset - 1, 'b');
+        const std::string str =
+            "\"" + before + special.bytes + after + "\"";
+        const std::string detail =
+            std::string(special.name) + ": " + escape(str);
+        const std::string expected =
+            special.decoded ? before + special.decoded + after : "";
+
+        json::arena retained;
+        for (json::arena *arena :
+             {static_cast<json::arena *>(nullptr), &retained}) {
+          outcome result = parse(str, arena);
+          if (special.decoded) {
+            check(!result.error && expected == result.string,
+                  arena ? "parser arena" : "parser", detail);
+          } else {
+            // NOTE: The error is at the special byte, after the quote.
+            check(result.error && !strcmp(special.error, result.error) &&
+                      1 == result.line && offset + 2 == result.column,
+                  arena ? "parser arena" : "parser", detail);
+          }
+        }
+
+        json::tape tape;
+        const bool recorded = json::read(str, tape, false);
+        check(special.decoded ? recorded && expected == tape.root().string()
+                              : !recorded,
+              "tape", detail);
+
+        if (special.decoded) {
+          check(expected == json::read(str, false).string(), "read", detail);
+          json::document document;
+          check(expected == json::read(str, document, false).string(),
+                "document", detail);
+        }
+      }
+    }
+  }
+}
+
+/// @brief A newline and a byte which is not whitespace at every offset of a
+/// run of whitespace, the line and column of the byte are counted by the
+/// whitespace scan.
+void test_whitespace() {
+  const char *const bytes[] = {"x", "\x0b", "\x80", "\xa0", "\xff", "\x01"};
+  const char *const spaces = " \t\r";
+  for (const char *byte : bytes) {
+    for (size_t size = 0; size <= longest; size++) {
+      // NOTE: A newline at each offset, or none.
+      for (size_t newline = 0; newline <= size; newline++) {
+        std::string run;
+        for (size_t index = 0; index < size; index++) {
+          run.push_back(newline == index ? '\n' : spaces[index % 3]);
+        }
+        const std::string str = "[" + run + byte + "]";
+        const std::string detail = escape(str);
+
+        size_t line = 1;
+        size_t column = 1 + 1 + size;
+        if (newline < size) {
+          line = 2;
+          column = size - newline;
+        }
+        outcome result = parse(str, nullptr);
+        check(result.error &&
+                  !strcmp("Unexpected character whilst attempting to read "
+                          "value.",
+                          result.error) &&
+                  line == result.line && column == result.column,
+              "whitespace", detail + " at " + std::to_string(result.line) +
+                                ":" + std::to_string(result.column));
+
+        json::tape tape;
+        check(!json::read(str, tape, false), "tape whitespace", detail);
+
+        // NOTE: The same run is skipped before a valid value.
+        const std::string valid = "[" + run + "1" + run + "]";
+        check(1 == json::read(valid, false).array().size() &&
+                  parse(valid, nullptr).error == nullptr &&
+                  json::read(valid, tape, false) && 1 == tape.root().size(),
+              "valid whitespace", escape(valid));
+      }
+    }
+  }
+}
+
+int main() {
+  test_strings();
+  test_whitespace();
+  printf("%s: %d of %d checks passed\n", failures ? "FAIL" : "PASS",
+         checks - failures, checks);
+  return failures ? 1 : 0;
+}
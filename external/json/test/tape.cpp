@@ -0,0 +1,210 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+const char *const source =
+    "{\"id\": 42, \"name\": \"caf\\u00e9\", \"ratio\": -0.25,\n"
+    " \"flags\": [true, false, null],\n"
+    " \"nested\": {\"empty\": {}, \"none\": [], \"deep\": [[1], [2, 3]]},\n"
+    " \"last\": \"\\\"quoted\\\"\"}";
+
+/// @brief Name of a type for failure messages.
+const char *type_name(json::type type) {
+  switch (type) {
+    case json::TYPE_OBJECT:
+      return "object";
+    case json::TYPE_ARRAY:
+      return "array";
+    case json::TYPE_NUMBER:
+      return "number";
+    case json::TYPE_STRING:
+      return "string";
+    case json::TYPE_BOOL:
+      return "bool";
+    default:
+      return "null";
+  }
+}
+
+/// @brief Nodes are found by key and index, iterated in order and skip the
+/// nodes they contain.
+void test_navigate() {
+  json::tape tape;
+  check(json::read(source, tape), "read", "document recorded");
+  const json::node &root = tape.root();
+  check(json::TYPE_OBJECT == root.type() && 6 == root.size(), "root",
+        std::to_string(root.size()) + " entries");
+
+  const json::node *id = root.get("id");
+  const json::node *name = root.get("name");
+  const json::node *ratio = root.get("ratio");
+  check(id && json::TYPE_NUMBER == id->type() && id->integer() &&
+            42 == id->number<int>(),
+        "integer", id ? id->view().str() : "missing");
+  check(name && name->escaped() && "caf\xc3\xa9" == name->string() &&
+            "caf\\u00e9" == name->view().str(),
+        "escaped", name ? name->string() : "missing");
+  check(ratio && !ratio->integer() && -0.25 == ratio->number(), "real",
+        ratio ? ratio->view().str() : "missing");
+  check(!root.get("missing") && !root.get("empty"), "missing",
+        "keys of nested objects are not found");
+
+  // NOTE: Keys are visited in order, values follow the nodes they skip.
+  std::string keys;
+  for (auto entry = root.begin(); root.end() != entry; ++entry) {
+    keys += entry->string() + ":" + type_name(entry.value().type()) + " ";
+  }
+  check("id:number name:string ratio:number flags:array nested:object "
+        "last:string " == keys,
+        "keys", keys);
+
+  const json::node *flags = root.get("flags");
+  std::vector<json::type> types;
+  for (auto &element : flags->array()) {
+    types.push_back(element.type());
+  }
+  check(3 == flags->size() && 3 == types.size() &&
+            json::TYPE_BOOL == types[0] && json::TYPE_BOOL == types[1] &&
+            json::TYPE_NULL == types[2] && (*flags->begin()).boolean(),
+        "array", std::to_string(flags->size()) + " elements");
+
+  const json::node *nested = root.get("nested");
+  const json::node *deep = nested->get("deep");
+  check(0 == nested->get("empty")->size() &&
+            nested->get("empty")->begin() == nested->get("empty")->end() &&
+            0 == nested->get("none")->size() && 2 == deep->size(),
+        "nested", json::write(nested->value(), json::compact));
+
+  int sum = 0;
+  for (auto &inner : deep->array()) {
+    for (auto &number : inner.array()) {
+      sum += number.number<int>();
+    }
+  }
+  check(6 == sum, "deep", std::to_string(sum));
+  check("\"quoted\"" == root.get("last")->string(), "last",
+        root.get("last")->string());
+
+  // NOTE: The value read from the tape matches the value read directly.
+  check(json::write(json::read(source), json::compact) ==
+            json::write(root.value(), json::compact),
+        "value", json::write(root.value(), json::compact));
+}
+
+/// @brief Scalars at the root of a document.
+void test_scalars() {
+  json::tape tape;
+  check(json::read("  \"text\"  ", tape) &&
+            json::TYPE_STRING == tape.root().type() &&
+            "text" == tape.root().string(),
+        "string", tape.root().string());
+  check(json::read("true", tape) && tape.root().boolean(), "true", "true");
+  check(json::read("false", tape) && !tape.root().boolean(), "false",
+        "false");
+  check(json::read("null", tape) && json::TYPE_NULL == tape.root().type(),
+        "null", "null");
+  check(json::read("-7", tape) && -7 == tape.root().number<int>(), "number",
+        "-7");
+}
+
+/// @brief Malformed documents are rejected and leave a null root, the tape
+/// can be reused afterwards.
+void test_errors() {
+  const char *const invalid[] = {"",
+                                 "   ",
+                                 "{",
+                                 "[1, 2",
+                                 "[1 2]",
+                                 "[1,]",
+                                 "{\"a\" 1}",
+                                 "{\"a\": 1,}",
+                                 "{1: 2}",
+                                 "\"open",
+                                 "\"\\q\"",
+                                 "\"\\u00zz\"",
+                                 "\"\\u12\"",
+                                 "\"\\u0000\"",
+                                 "\"line\nbreak\"",
+                                 "\"\xff\"",
+                                 "tru",
+                                 "nul",
+                                 "[] []",
+                                 "{} x"};
+  json::tape tape;
+  for (const char *str : invalid) {
+    check(!json::read(str, tape, false) &&
+              json::TYPE_NULL == tape.root().type(),
+          "invalid", str);
+  }
+  check(json::read("[1]", tape) && 1 == tape.root().size(), "reuse", "[1]");
+}
+
+/// @brief Every reader decodes '\u' escapes to the same UTF-8.
+void test_unicode() {
+  struct escape {
+    const char *str;
+    const char *decoded;
+  };
+  const escape escapes[] = {{"\"\\u00e9\"", "\xc3\xa9"},
+                            {"\"\\u00E9\"", "\xc3\xa9"},
+                            {"\"\\u0041\"", "A"},
+                            {"\"\\u20ac!\"", "\xe2\x82\xac!"},
+                            {"\"a\\u00e9b\\u00e9\"", "a\xc3\xa9" "b\xc3\xa9"},
+                            {"\"\\uFFFF\"", "\xef\xbf\xbf"}};
+  for (auto &escape : escapes) {
+    const std::string str = escape.str;
+    check(escape.decoded == json::read(str).string(), "read", str);
+
+    json::document document;
+    check(escape.decoded == json::read(str, document).string(), "document",
+          str);
+
+    json::parser parser;
+    check(parser.feed(str) && parser.finish() &&
+              escape.decoded == parser.value().string(),
+          "parser", str);
+
+    json::tape tape;
+    check(json::read(str, tape) && escape.decoded == tape.root().string(),
+          "tape", str);
+  }
+}
+
+int main() {
+  test_navigate();
+  test_scalars();
+  test_errors();
+  test_unicode();
+  return failures ? 1 : 0;
+}
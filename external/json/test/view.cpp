@@ -0,0 +1,141 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+const char *const source =
+    "{\"plain\": \"first value\", \"escaped\": \"a\\tb\", "
+    "\"list\": [\"second\", \"caf\xc3\xa9\"]}";
+
+/// @brief Offset of the first occurrence of a string in the source.
+ptrdiff_t offset(const char *str) { return strstr(source, str) - source; }
+
+/// @brief Strings read into a document without escapes view a copy of the
+/// source retained by its arena, those with escapes are decoded.
+void test_document() {
+  json::document document;
+  {
+    // NOTE: The document must not depend on the string it was read from.
+    std::string str = source;
+    json::read(str, document);
+    str.assign(str.size(), 'x');
+  }
+  json::object &object = document.root().object();
+  json::view plain = object.get("plain")->view();
+  json::view second = object.get("list")->array()[0].view();
+  json::view cafe = object.get("list")->array()[1].view();
+  check("first value" == plain.str() && "second" == second.str() &&
+            "caf\xc3\xa9" == cafe.str(),
+        "document", plain.str() + ", " + second.str() + ", " + cafe.str());
+
+  // NOTE: Views are at the same distance apart as in the source.
+  check(offset("second") - offset("first value") ==
+                second.data() - plain.data() &&
+            offset("caf") - offset("first value") ==
+                cafe.data() - plain.data(),
+        "retained", "views point into the retained source");
+
+  json::view escaped = object.get("escaped")->view();
+  check("a\tb" == escaped.str(), "escaped", escaped.str());
+
+  // NOTE: Accessing the string constructs it in place of the view.
+  std::string &string = object.get("plain")->string();
+  check("first value" == string && string.data() != plain.data(),
+        "materialize", string);
+  string += "!";
+  check("first value!" == object.get("plain")->view().str(), "modify",
+        object.get("plain")->view().str());
+
+  // NOTE: Copies own their characters.
+  json::value copy = object.get("list")->array()[0];
+  check("second" == copy.view().str() && copy.view().data() != second.data(),
+        "copy", copy.string());
+}
+
+/// @brief Strings read by a parser with an arena view characters retained by
+/// the arena, never the data which was fed.
+void test_parser() {
+  json::arena arena;
+  json::parser parser(&arena);
+  std::string str = source;
+  const size_t half = str.size() / 2;
+  bool success = parser.feed(str.data(), half);
+  str.replace(0, half, half, 'x');
+  success = success && parser.feed(str.data() + half, str.size() - half);
+  str.assign(str.size(), 'x');
+  success = success && parser.finish();
+  json::object &object = parser.value().object();
+  check(success && "first value" == object.get("plain")->view().str() &&
+            "a\tb" == object.get("escaped")->view().str() &&
+            "second" == object.get("list")->array()[0].view().str() &&
+            "caf\xc3\xa9" == object.get("list")->array()[1].view().str(),
+        "parser", json::write(parser.value(), json::compact));
+}
+
+/// @brief Nodes of a tape view the source they were recorded from.
+void test_tape() {
+  std::string str = source;
+  // NOTE: The source is moved onto the tape, its characters stay in place.
+  const char *data = str.data();
+  json::tape tape;
+  const bool success = json::read(std::move(str), tape);
+  const json::node &root = tape.root();
+  const json::node *plain = root.get("plain");
+  const json::node *escaped = root.get("escaped");
+  check(success && plain &&
+            data + offset("first value") == plain->view().data() &&
+            "first value" == plain->view().str() && !plain->escaped(),
+        "tape", plain ? plain->string() : "missing");
+  check(escaped && escaped->escaped() && "a\\tb" == escaped->view().str() &&
+            "a\tb" == escaped->string(),
+        "tape escaped", escaped ? escaped->string() : "missing");
+}
+
+/// @brief Views compare by their characters.
+void test_compare() {
+  const char chars[] = "keykey";
+  json::view first(chars, 3);
+  json::view second(chars + 3, 3);
+  check(first == second && first != json::view(chars, 4) &&
+            json::view() == json::view(std::string()) &&
+            "key" == first.str(),
+        "compare", first.str());
+}
+
+int main() {
+  test_document();
+  test_parser();
+  test_tape();
+  test_compare();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+// Copyright (C) 2015 Kenneth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <json/json.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+const char *const source =
+    "{\"id\": 7, \"name\": \"a \\\"quoted\\\" \\\\ / caf\xc3\xa9\", "
+    "\"escapes\": \"\\b\\f\\n\\r\\t\\u0001\\u001f\", \"ratio\": 0.5, "
+    "\"empty\": {}, \"none\": [], \"list\": [true, false, null, -1], "
+    "\"nested\": {\"a\": [{\"b\": 1e100}]}}";
+
+/// @brief Write a value to a temporary file and read the file back.
+std::string write_file(const json::value &value, const char *tab) {
+  FILE *file = std::tmpfile();
+  if (!file || !json::write(value, file, tab)) {
+    return "write failed";
+  }
+  std::string str(static_cast<size_t>(std::ftell(file)), '\0');
+  std::rewind(file);
+  str.resize(std::fread(&str[0], 1, str.size(), file));
+  std::fclose(file);
+  return str;
+}
+
+/// @brief Stream a document through json::writer into a temporary file.
+std::string stream_file(const std::string &str, const char *tab) {
+  FILE *file = std::tmpfile();
+  if (!file) {
+    return "write failed";
+  }
+  {
+    json::writer writer(file, tab);
+    if (!json::read(str, writer) || !writer.flush()) {
+      return "write failed";
+    }
+  }
+  std::string written(static_cast<size_t>(std::ftell(file)), '\0');
+  std::rewind(file);
+  written.resize(std::fread(&written[0], 1, written.size(), file));
+  std::fclose(file);
+  return written;
+}
+
+/// @brief Compact output has no whitespace, strings escape only what they
+/// must and every way of writing agrees.
+void test_compact() {
+  const std::string expected =
+      "{\"id\":7,\"name\":\"a \\\"quoted\\\" \\\\ / caf\xc3\xa9\","
+      "\"escapes\":\"\\b\\f\\n\\r\\t\\u0001\\u001f\",\"ratio\":0.5,"
+      "\"empty\":{},\"none\":[],\"list\":[true,false,null,-1],"
+      "\"nested\":{\"a\":[{\"b\":1e+100}]}}";
+  json::value value = json::read(source);
+  const std::string compact = json::write(value, json::compact);
+  check(expected == compact, "compact", compact);
+
+  // NOTE: Writing into a buffer appends to it.
+  std::string buffer = "prefix";
+  json::write(value, buffer, json::compact);
+  check("prefix" + expected == buffer, "buffer", buffer);
+
+  check(expected == write_file(value, json::compact), "file",
+        write_file(value, json::compact));
+  check(expected == stream_file(source, json::compact), "writer",
+        stream_file(source, json::compact));
+
+  // NOTE: Compact output reads back to the same document.
+  check(compact == json::write(json::read(compact), json::compact),
+        "reread", compact);
+}
+
+/// @brief Pretty output is the same however it is written.
+void test_pretty() {
+  json::value value = json::read(source);
+  const std::string pretty = json::write(value, "  ");
+  check(std::string::npos != pretty.find("\n  \"id\": 7,\n") &&
+            std::string::npos != pretty.find("\n      {\n        \"b\": "),
+        "pretty", pretty);
+  check(pretty == write_file(value, "  "), "pretty file",
+        write_file(value, "  "));
+  check(pretty == stream_file(source, "  "), "pretty writer",
+        stream_file(source, "  "));
+  check(json::write(value) == stream_file(source, "\t"), "tab writer",
+        stream_file(source, "\t"));
+
+  // NOTE: Output larger than the buffer is written in several parts.
+  json::array array;
+  for (size_t index = 0; index < 20000; index++) {
+    array.append(json::value("entry " + std::to_string(index)));
+  }
+  json::value large(std::move(array));
+  const std::string str = json::write(large, "  ");
+  check(str == write_file(large, "  ") && str == stream_file(str, "  "),
+        "large", std::to_string(str.size()) + " bytes");
+}
+
+/// @brief Read back what was written for a double.
+double round_trip(double number) {
+  return json::read(json::write(json::value(number), json::compact))
+      .number();
+}
+
+/// @brief Doubles are written with enough digits to read back exactly,
+/// integers are written exactly.
+void test_numbers() {
+  const double doubles[] = {0.1,
+                            1.0 / 3.0,
+                            2.0 / 3.0,
+                            1e23,
+                            123456789012345680.0,
+                            5e-324,
+                            2.2250738585072014e-308,
+                            std::numeric_limits<double>::max(),
+                            -std::numeric_limits<double>::max(),
+                            0.30000000000000004,
+                            9007199254740993.0};
+  for (double number : doubles) {
+    const double read = round_trip(number);
+    check(0 == std::memcmp(&number, &read, sizeof(double)), "double",
+          json::write(json::value(number), json::compact));
+  }
+
+  // NOTE: Doubles from random bit patterns, skipping NaN and infinity.
+  std::mt19937_64 random(42);
+  size_t mismatches = 0;
+  size_t count = 0;
+  while (count < 100000) {
+    const uint64_t bits = random();
+    double number;
+    std::memcpy(&number, &bits, sizeof(number));
+    if (!std::isfinite(number) || 0 == number) {
+      continue;
+    }
+    count++;
+    const double read = round_trip(number);
+    if (0 != std::memcmp(&number, &read, sizeof(double))) {
+      mismatches++;
+    }
+  }
+  check(0 == mismatches, "random doubles",
+        std::to_string(mismatches) + " of " + std::to_string(count) +
+            " did not read back exactly");
+
+  check("0" == json::write(json::value(0.0)) &&
+            "null" == json::write(json::value(
+                          std::numeric_limits<double>::infinity())) &&
+            "null" == json::write(json::value(std::nan(""))),
+        "special", "zero and non-finite doubles");
+
+  check("-9223372036854775808" ==
+                json::write(json::value(std::numeric_limits<int64_t>::min())) &&
+            "18446744073709551615" ==
+                json::write(
+                    json::value(std::numeric_limits<uint64_t>::max())) &&
+            "9007199254740993" ==
+                json::write(json::value(uint64_t(9007199254740993u))),
+        "integers", "written exactly");
+}
+
+int main() {
+  test_compact();
+  test_pretty();
+  test_numbers();
+  return failures ? 1 : 0;
+}
@@ -22,41 +22,65 @@
 
 #include <stdio.h>
 
-#include <string>
-#include <fstream>
-
 enum result_t : int {
   SUCCESS = 0,
   FAILURE = 1,
 };
 
 enum option_t {
-  // TODO: Options?
+  OPTION_NONE = 0,
+  OPTION_STREAM = 1 << 0,
 };
 
-void print_usage() { printf("Usage: jsonv <json file>\n"); }
+void print_usage() {
+  printf(
+      "Usage: jsonv [-s] <json file>\n"
+      "\n"
+      "  -s  stream the file, pretty printing it in constant memory\n");
+}
 
 int main(int argc, char **argv) {
-  if (2 != argc) {
-    print_usage();
-    return FAILURE;
-  }
+  const char *path = nullptr;
+  int options = OPTION_NONE;
   for (int i = 1; i < argc; ++i) {
-    switch (argv[i][0]) {
-      // TODO: Options?
-      default:
+    if ('-' != argv[i][0]) {
+      if (path) {
+        print_usage();
+        return FAILURE;
+      }
+      path = argv[i];
+      continue;
+    }
+    switch (argv[i][1]) {
+      case 's':
+        options |= OPTION_STREAM;
         break;
+      default:
+        print_usage();
+        return FAILURE;
     }
   }
+  if (!path) {
+    print_usage();
+    return FAILURE;
+  }
 
-  std::ifstream file(argv[1]);
-  std::string str((std::istreambuf_iterator<char>(file)),
-                  std::istreambuf_iterator<char>());
-
-  json::value value = json::read(str);
-  std::string json = json::write(value, "  ");
+  if (OPTION_STREAM & options) {
+    // NOTE: Values are written as they are read, nothing is retained.
+    json::writer writer(stdout, "  ");
+    const bool success = json::read_file(path, writer);
+    if (!writer.flush()) {
+      return FAILURE;
+    }
+    printf("\n");
+    return success ? SUCCESS : FAILURE;
+  }
 
-  printf("%s\n", json.c_str());
+  json::value value = json::read_file(path);
+  if (!json::write(value, stdout, "  ")) {
+    return FAILURE;
+  }
+  printf("\n");
 
   return SUCCESS;
 }
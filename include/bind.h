@@ -0,0 +1,363 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef REDMINE_BIND_H
+#define REDMINE_BIND_H
+
+#include <redmine.h>
+
+#include <json/json.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Declare a field of a struct bound to the JSON key of the same name.
+///
+/// @param STRUCT The struct type.
+/// @param MEMBER The member of STRUCT holding the field.
+/// @param PRESENCE Either REQUIRED or OPTIONAL.
+#define BIND_FIELD(STRUCT, MEMBER, PRESENCE)                            \
+  redmine::bind::field<STRUCT>::make<decltype(STRUCT::MEMBER),         \
+                                     &STRUCT::MEMBER>(#MEMBER,         \
+                                                      redmine::bind::PRESENCE)
+
+namespace redmine {
+namespace bind {
+/// @brief Whether a field must be present in the JSON object.
+enum presence {
+  /// @brief The key must be present, reading fails otherwise.
+  REQUIRED,
+  /// @brief The key may be absent or null, the member is then left unchanged
+  /// and the key is not written when the member is empty.
+  OPTIONAL,
+};
+
+/// @brief Conversion of a member type to and from JSON.
+///
+/// The primary template handles structs which declare their own fields.
+template <class Type>
+struct traits {
+  static const json::type type = json::TYPE_OBJECT;
+
+  template <class Source>
+  static result read(const Source &source, Type &out);
+  static json::value write(const Type &in);
+  static bool empty(const Type &in);
+};
+
+/// @brief Most fields a struct may bind, fields read are tracked as the bits
+/// of a 64 bit mask and reading a struct binding more fails.
+const size_t max_fields = 64;
+
+/// @brief A member of a struct bound to a JSON key.
+template <class Struct>
+struct field {
+  /// @brief Create a field from a pointer to member given at compile time.
+  ///
+  /// @param key The JSON key, must outlive the program.
+  /// @param presence Whether the key must be present.
+  template <class Type, Type Struct::*Member>
+  static field make(const char *key, bind::presence presence);
+
+  /// @brief The JSON key.
+  const char *key;
+  /// @brief Length of the key.
+  size_t size;
+  /// @brief Whether the key must be present.
+  bind::presence presence;
+  /// @brief Read the member from a value of a json::object.
+  result (*read_value)(const json::value &value, Struct &out);
+  /// @brief Read the member from a node of a json::tape.
+  result (*read_node)(const json::node &node, Struct &out);
+  /// @brief Write the member to a json::object.
+  void (*write)(const Struct &in, const field &field, json::object &out);
+  /// @brief Check if the member holds its default value.
+  bool (*empty)(const Struct &in);
+};
+
+/// @brief Read the fields of a struct from a json::object in one pass.
+///
+/// @param object Object to read from.
+/// @param out Struct to initialise.
+///
+/// @return Returns either redmine::SUCCESS or redmine::FAILURE.
+template <class Struct>
+result read(const json::object &object, Struct &out);
+
+/// @brief Read the fields of a struct from an object on a json::tape in one
+/// pass.
+///
+/// @param node Object node to read from.
+/// @param out Struct to initialise.
+///
+/// @return Returns either redmine::SUCCESS or redmine::FAILURE.
+template <class Struct>
+result read(const json::node &node, Struct &out);
+
+/// @brief Write the fields of a struct to a json::object.
+///
+/// @param in Struct to write.
+///
+/// @return The constructed json::object.
+template <class Struct>
+json::object write(const Struct &in);
+
+template <>
+struct traits<uint32_t> {
+  static const json::type type = json::TYPE_NUMBER;
+
+  template <class Source>
+  static result read(const Source &source, uint32_t &out) {
+    out = source.template number<uint32_t>();
+    return SUCCESS;
+  }
+  static json::value write(const uint32_t &in) { return json::value(in); }
+  static bool empty(const uint32_t &in) { return 0 == in; }
+};
+
+template <>
+struct traits<std::string> {
+  static const json::type type = json::TYPE_STRING;
+
+  template <class Source>
+  static result read(const Source &source, std::string &out) {
+    out = source.string();
+    return SUCCESS;
+  }
+  static json::value write(const std::string &in) { return json::value(in); }
+  static bool empty(const std::string &in) { return in.empty(); }
+};
+
+template <>
+struct traits<bool> {
+  static const json::type type = json::TYPE_BOOL;
+
+  template <class Source>
+  static result read(const Source &source, bool &out) {
+    out = source.boolean();
+    return SUCCESS;
+  }
+  static json::value write(const bool &in) { return json::value(in); }
+  static bool empty(const bool &in) { return !in; }
+};
+
+template <class Type>
+struct traits<std::vector<Type>> {
+  static const json::type type = json::TYPE_ARRAY;
+
+  template <class Source>
+  static result read(const Source &source, std::vector<Type> &out) {
+    out.clear();
+    out.reserve(source.array().size());
+    for (auto &element : source.array()) {
+      CHECK_JSON_TYPE(element, traits<Type>::type);
+      Type entry;
+      CHECK_RETURN(traits<Type>::read(element, entry));
+      out.push_back(std::move(entry));
+    }
+    return SUCCESS;
+  }
+  static json::value write(const std::vector<Type> &in) {
+    json::array array;
+    array.reserve(in.size());
+    for (auto &entry : in) {
+      array.append(traits<Type>::write(entry));
+    }
+    return json::value(std::move(array));
+  }
+  static bool empty(const std::vector<Type> &in) { return in.empty(); }
+};
+
+template <class Type>
+template <class Source>
+result traits<Type>::read(const Source &source, Type &out) {
+  return bind::read(source.object(), out);
+}
+
+template <class Type>
+json::value traits<Type>::write(const Type &in) {
+  return json::value(bind::write(in));
+}
+
+template <class Type>
+bool traits<Type>::empty(const Type &in) {
+  for (auto &field : Type::fields()) {
+    if (!field.empty(in)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief Functions of a field bound to a pointer to member.
+template <class Struct, class Type, Type Struct::*Member>
+struct member {
+  template <class Source>
+  static result read(const Source &source, Struct &out) {
+    CHECK_JSON_TYPE(source, traits<Type>::type);
+    return traits<Type>::read(source, out.*Member);
+  }
+  static void write(const Struct &in, const field<Struct> &field,
+                    json::object &out) {
+    if (OPTIONAL == field.presence && traits<Type>::empty(in.*Member)) {
+      return;
+    }
+    out.add(field.key, traits<Type>::write(in.*Member));
+  }
+  static bool empty(const Struct &in) {
+    return traits<Type>::empty(in.*Member);
+  }
+};
+
+template <class Struct>
+template <class Type, Type Struct::*Member>
+field<Struct> field<Struct>::make(const char *key, bind::presence presence) {
+  return {key,
+          std::char_traits<char>::length(key),
+          presence,
+          &member<Struct, Type, Member>::template read<json::value>,
+          &member<Struct, Type, Member>::template read<json::node>,
+          &member<Struct, Type, Member>::write,
+          &member<Struct, Type, Member>::empty};
+}
+
+/// @brief Read one field from a value of a json::object.
+template <class Struct>
+result read_field(const field<Struct> &field, const json::value &value,
+                  Struct &out) {
+  return field.read_value(value, out);
+}
+
+/// @brief Read one field from a node of a json::tape.
+template <class Struct>
+result read_field(const field<Struct> &field, const json::node &node,
+                  Struct &out) {
+  return field.read_node(node, out);
+}
+
+/// @brief Read one field from the value of a key.
+///
+/// Keys usually arrive in the order the fields are declared so the search
+/// starts at the field after the last one found, a struct is then read in a
+/// single pass without a lookup per key.
+///
+/// @param fields Fields of the struct.
+/// @param key The key of the value.
+/// @param value The value to read.
+/// @param out Struct to initialise.
+/// @param seen Mask of the fields read so far.
+/// @param next Index of the field expected next.
+///
+/// @return Returns either redmine::SUCCESS or redmine::FAILURE.
+template <class Struct, class Source>
+result read_entry(const std::vector<field<Struct>> &fields,
+                  const json::view &key, const Source &value, Struct &out,
+                  uint64_t &seen, size_t &next) {
+  size_t index = next;
+  size_t count = 0;
+  for (; count < fields.size(); count++) {
+    if (key == json::view(fields[index].key, fields[index].size)) {
+      break;
+    }
+    index = fields.size() == index + 1 ? 0 : index + 1;
+  }
+  if (fields.size() == count) {
+    // NOTE: Keys which are not bound are skipped.
+    return SUCCESS;
+  }
+  next = fields.size() == index + 1 ? 0 : index + 1;
+  if (json::TYPE_NULL == value.type() && OPTIONAL == fields[index].presence) {
+    return SUCCESS;
+  }
+  CHECK_RETURN(read_field(fields[index], value, out));
+  seen |= uint64_t(1) << index;
+  return SUCCESS;
+}
+
+/// @brief Check the fields of a struct fit in the mask of fields read.
+template <class Struct>
+result check_fields(const std::vector<field<Struct>> &fields) {
+  CHECK(max_fields < fields.size(),
+        ERROR_MSG("%zu fields bound, at most %zu are supported\n",
+                  fields.size(), max_fields);
+        return FAILURE);
+  return SUCCESS;
+}
+
+/// @brief Check every required field was read.
+template <class Struct>
+result read_required(const std::vector<field<Struct>> &fields, uint64_t seen) {
+  for (size_t index = 0; index < fields.size(); index++) {
+    if (REQUIRED == fields[index].presence &&
+        !(seen & uint64_t(1) << index)) {
+      DEBUG_MSG("json is missing %s\n", fields[index].key);
+      return FAILURE;
+    }
+  }
+  return SUCCESS;
+}
+
+template <class Struct>
+result read(const json::object &object, Struct &out) {
+  auto &fields = Struct::fields();
+  CHECK_RETURN(check_fields(fields));
+  uint64_t seen = 0;
+  size_t next = 0;
+  for (auto &entry : object) {
+    CHECK_RETURN(
+        read_entry(fields, entry.first, entry.second, out, seen, next));
+  }
+  return read_required(fields, seen);
+}
+
+template <class Struct>
+result read(const json::node &node, Struct &out) {
+  auto &fields = Struct::fields();
+  CHECK_RETURN(check_fields(fields));
+  uint64_t seen = 0;
+  size_t next = 0;
+  std::string key;
+  for (auto entry = node.begin(); node.end() != entry; ++entry) {
+    if (entry->escaped()) {
+      key = entry->string();
+      CHECK_RETURN(read_entry(fields, key, entry.value(), out, seen, next));
+    } else {
+      CHECK_RETURN(
+          read_entry(fields, entry->view(), entry.value(), out, seen, next));
+    }
+  }
+  return read_required(fields, seen);
+}
+
+template <class Struct>
+json::object write(const Struct &in) {
+  json::object object;
+  auto &fields = Struct::fields();
+  object.reserve(fields.size());
+  for (auto &field : fields) {
+    field.write(in, field, object);
+  }
+  return object;
+}
+}  // bind
+}  // redmine
+
+#endif  // REDMINE_BIND_H
@@ -0,0 +1,74 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef REDMINE_CACHE_H
+#define REDMINE_CACHE_H
+
+#include <config.h>
+#include <redmine.h>
+
+#include <cstdint>
+#include <string>
+
+namespace redmine {
+namespace cache {
+/// @brief A cached HTTP response.
+struct entry {
+  /// @brief Default constructor.
+  entry();
+
+  /// @brief Value of the responses ETag header, may be empty.
+  std::string etag;
+  /// @brief Value of the responses Last-Modified header, may be empty.
+  std::string last_modified;
+  /// @brief Time in seconds since the epoch the response was last validated.
+  uint64_t time;
+  /// @brief Response data body.
+  std::string body;
+};
+
+/// @brief Load the cached response for a URL.
+///
+/// Entries are stored per profile in the users cache directory, on Linux this
+/// is `$XDG_CACHE_HOME/redmine/<profile>` falling back to
+/// `~/.cache/redmine/<profile>`.
+///
+/// @param config The users redmine configuration.
+/// @param url The full URL of the request.
+/// @param entry The loaded cache entry.
+///
+/// @return Returns redmine::SUCCESS if an entry was found, redmine::FAILURE
+/// otherwise.
+result load(const redmine::config &config, const std::string &url,
+            entry &entry);
+
+/// @brief Store the response for a URL in the cache.
+///
+/// @param config The users redmine configuration.
+/// @param url The full URL of the request.
+/// @param entry The cache entry to store.
+///
+/// @return Returns redmine::SUCCESS or redmine::FAILURE.
+result store(const redmine::config &config, const std::string &url,
+             const entry &entry);
+}  // cache
+}  // redmine
+
+#endif  // REDMINE_CACHE_H
@@ -55,6 +55,17 @@ struct config {
     uint32_t port;
     bool use_ssl;
     bool verify_ssl;
+    /// @brief Maximum number of concurrent requests in a batch.
+    uint32_t concurrency;
+    /// @brief Seconds a cached response is used without revalidation.
+    uint32_t cache_max_age;
+    /// @brief Seconds the resolved permissions of each role are cached.
+    uint32_t permissions_max_age;
+    /// @brief Number of times an idempotent request is retried after a
+    /// transient failure.
+    uint32_t retries;
+    /// @brief Milliseconds before the first retry, doubled for each retry.
+    uint32_t retry_delay;
   };
 
   std::string editor;
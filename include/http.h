@@ -24,7 +24,15 @@
 #include <config.h>
 #include <redmine.h>
 
+#include <json/json.hpp>
+
+#include <deque>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+struct curl_slist;
 
 namespace redmine {
 namespace http {
@@ -600,15 +608,69 @@ struct code {
   static const status NETWORK_CONNECT_TIMEOUT_ERROR = 599;
 };
 
-/// @brief Global HTTP session RAII helper.
+/// @brief Persistent HTTP client session.
+///
+/// A single session is created in ::main and lives for the duration of the
+/// process. It owns a long-lived easy handle, a share handle caching DNS
+/// lookups, TLS sessions and connections, the prebuilt request header list and
+/// the base URL of the current profile. All requests made through
+/// redmine::http::get, redmine::http::post and redmine::http::put are routed
+/// through the active session so that they reuse warm connections instead of
+/// paying a new TCP connect and TLS handshake each time.
 struct session {
-  /// @brief Initialise HTTP session.
+  /// @brief Default constructor.
+  session();
+
+  /// @brief Initialise HTTP session and make it the active session.
   ///
   /// @return Any CURL error code, or SUCCESS.
   result init();
 
-  /// @brief Clean up global HTTP handler state.
+  /// @brief Prepare the base URL and request headers for a profile.
+  ///
+  /// This is cheap to call before every request, the header list is only
+  /// rebuilt when the current profile changes.
+  ///
+  /// @param config The users redmine configuration.
+  ///
+  /// @return Return redmine::SUCCESS or redmine::FAILURE.
+  result prepare(const redmine::config &config);
+
+  /// @brief Clean up owned handles and global HTTP handler state.
   ~session();
+
+  /// @brief Long-lived CURL easy handle reused for every request.
+  void *handle;
+  /// @brief CURL share handle for DNS, TLS session and connection caches.
+  void *share;
+  /// @brief Prebuilt request header list containing the API key.
+  struct curl_slist *header;
+  /// @brief Base URL of the profile the header list was built for.
+  std::string url;
+  /// @brief API key of the profile the header list was built for.
+  std::string key;
+  /// @brief CURL multi handle driving batched requests.
+  void *multi;
+  /// @brief Pool of long-lived easy handles used by batched requests.
+  std::vector<void *> handles;
+  /// @brief Prefetched response bodies keyed by path, consumed by
+  /// redmine::http::get.
+  std::unordered_map<std::string, std::string> responses;
+
+ private:
+  session(const session &) = delete;
+  session &operator=(const session &) = delete;
+};
+
+/// @brief Caching policy of a GET request.
+enum caching {
+  /// @brief Always perform the request.
+  UNCACHED,
+  /// @brief Store the response in the on-disk cache and revalidate it with a
+  /// conditional request, treating HTTP 304 as a cache hit. Cached responses
+  /// younger than redmine::config::profile::cache_max_age are used without
+  /// a request at all.
+  CACHED,
 };
 
 /// @brief Perform an HTTP GET request.
@@ -617,10 +679,200 @@ struct session {
 /// @param config The users redmine configuration.
 /// @param options Enabled options.
 /// @param body Response data body.
+/// @param caching Caching policy, use redmine::http::CACHED for reference
+/// data which rarely changes.
+///
+/// @return Return redmine::SUCCESS or redmine::FAILURE.
+result get(const std::string &path, const redmine::config &config,
+           redmine::options &options, std::string &body,
+           const http::caching caching = UNCACHED);
+
+/// @brief Perform an HTTP GET request parsing the JSON response body as it
+/// is received, the body is not buffered unless it is to be cached.
+///
+/// @param path The path of the UTR to the request to.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param value Parsed response data body.
+/// @param caching Caching policy, use redmine::http::CACHED for reference
+/// data which rarely changes.
 ///
 /// @return Return redmine::SUCCESS or redmine::FAILURE.
 result get(const std::string &path, const redmine::config &config,
-           redmine::options &options, std::string &body);
+           redmine::options &options, json::value &value,
+           const http::caching caching = UNCACHED);
+
+/// @brief Perform an HTTP GET request parsing the JSON response body into a
+/// document, all values are allocated from the documents arena.
+///
+/// Prefer this for large responses, the document is released in one step.
+///
+/// @param path The path of the UTR to the request to.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param document Parsed response data body.
+/// @param caching Caching policy, use redmine::http::CACHED for reference
+/// data which rarely changes.
+///
+/// @return Return redmine::SUCCESS or redmine::FAILURE.
+result get(const std::string &path, const redmine::config &config,
+           redmine::options &options, json::document &document,
+           const http::caching caching = UNCACHED);
+
+/// @brief Perform an HTTP GET request recording the JSON response body on a
+/// tape, values are only read when they are accessed.
+///
+/// Prefer this when only a few fields of a large response are used.
+///
+/// @param path The path of the UTR to the request to.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param tape Recorded response data body.
+/// @param caching Caching policy, use redmine::http::CACHED for reference
+/// data which rarely changes.
+///
+/// @return Return redmine::SUCCESS or redmine::FAILURE.
+result get(const std::string &path, const redmine::config &config,
+           redmine::options &options, json::tape &tape,
+           const http::caching caching = UNCACHED);
+
+/// @brief Perform an HTTP GET request sending the events of the JSON response
+/// body to a handler as it is received, no json::value tree is built.
+///
+/// @param path The path of the UTR to the request to.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param handler Receives the events of the response data body.
+/// @param caching Caching policy, use redmine::http::CACHED for reference
+/// data which rarely changes.
+///
+/// @return Return redmine::SUCCESS or redmine::FAILURE, including when the
+/// handler stops reading.
+result get(const std::string &path, const redmine::config &config,
+           redmine::options &options, json::handler &handler,
+           const http::caching caching = UNCACHED);
+
+/// @brief A single request in a batch.
+struct request {
+  /// @brief Construct a request for a path.
+  ///
+  /// @param path The path of the URL to send the request to.
+  /// @param caching Caching policy of the request.
+  request(const std::string &path, const http::caching caching = UNCACHED);
+
+  /// @brief The path of the URL to send the request to.
+  std::string path;
+  /// @brief Caching policy of the request.
+  http::caching caching;
+  /// @brief Response data body.
+  std::string body;
+  /// @brief HTTP status code of the response.
+  http::status status;
+  /// @brief Either redmine::SUCCESS or the reason this request failed.
+  result error;
+};
+
+/// @brief Perform a batch of HTTP GET requests concurrently.
+///
+/// Requests are driven by a CURL multi handle with at most
+/// redmine::config::profile::concurrency requests in flight at once. Each
+/// request records its own status and error, errors are reported to stderr in
+/// the same way as a single redmine::http::get.
+///
+/// @param requests The requests to perform, responses are stored in place.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param complete Optionally called with each request once it has its final
+/// response or error, in the order they complete.
+///
+/// @return Return redmine::SUCCESS if all requests succeeded, or the error of
+/// the first failed request otherwise.
+result get(std::vector<http::request> &requests, const redmine::config &config,
+           redmine::options &options,
+           const std::function<void(http::request &)> &complete = nullptr);
+
+/// @brief Concurrently fetch paths which will be requested shortly.
+///
+/// Successful responses are held by the active session and handed out by the
+/// next redmine::http::get of the same path without another round-trip. This
+/// is best-effort, failed requests are not kept so the path is simply
+/// requested again by redmine::http::get.
+///
+/// @param requests The requests to perform.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+void prefetch(std::vector<http::request> requests,
+              const redmine::config &config, redmine::options &options);
+
+/// @brief Largest number of entries Redmine returns in a page.
+const uint32_t page_limit = 100;
+
+/// @brief Append the query of a page of a paginated collection to a path.
+///
+/// @param path Path of the collection, may already have a query.
+/// @param offset Index of the first entry of the page.
+/// @param limit Number of entries in the page.
+///
+/// @return Returns the path of the page.
+std::string page(const std::string &path, const uint32_t offset = 0,
+                 const uint32_t limit = page_limit);
+
+/// @brief Perform the GET requests of every page of a paginated collection.
+///
+/// The first page is requested on its own, its total_count and limit then
+/// decide the offsets of the remaining pages which are requested concurrently
+/// as one batch. Collections which are not paginated, the first page has no
+/// limit, are a single page.
+///
+/// @param path Path of the collection, may already have a query.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param pages Requests of each page in order of offset, the responses are
+/// stored in place.
+/// @param caching Caching policy of each page.
+///
+/// @return Return redmine::SUCCESS if all pages were received, or the error
+/// of the first failed request otherwise.
+result get_pages(const std::string &path, const redmine::config &config,
+                 redmine::options &options, std::vector<http::request> &pages,
+                 const http::caching caching = UNCACHED);
+
+/// @brief Perform the GET requests of every page of a paginated collection
+/// recording each page on a tape.
+///
+/// @param path Path of the collection, may already have a query.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param pages Recorded response of each page in order of offset.
+/// @param caching Caching policy of each page.
+///
+/// @return Return redmine::SUCCESS or redmine::FAILURE.
+result get_pages(const std::string &path, const redmine::config &config,
+                 redmine::options &options, std::deque<json::tape> &pages,
+                 const http::caching caching = UNCACHED);
+
+/// @brief Perform the GET requests of every page of a paginated collection
+/// reading each page as soon as those before it have been read.
+///
+/// The first page is read before the remaining pages are requested, those are
+/// read while the pages after them are still in flight and their bodies are
+/// released once read. At most redmine::config::profile::concurrency pages
+/// past the next to read are requested, and once reading fails no more are
+/// requested and those in flight are abandoned.
+///
+/// @param path Path of the collection, may already have a query.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param read Reads a page, the body may be moved from. Pages are no longer
+/// read once it fails.
+/// @param caching Caching policy of each page.
+///
+/// @return Return redmine::SUCCESS if all pages were read, or the first error
+/// otherwise.
+result get_pages(const std::string &path, const redmine::config &config,
+                 redmine::options &options,
+                 const std::function<result(http::request &page)> &read,
+                 const http::caching caching = UNCACHED);
 
 /// @brief Perform a POST request.
 ///
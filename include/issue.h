@@ -28,6 +28,7 @@
 
 #include <json/json.hpp>
 
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -36,12 +37,13 @@ struct issue {
   /// @brief Default constructor.
   issue();
 
-  /// @brief Initialise from json::object.
+  /// @brief Initialise from json::object or a json::node of a json::tape.
   ///
   /// @param object Object to initilise redmine::issue from.
   ///
   /// @return Return either redmine::SUCCESS or redmine::FAILURE.
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
 
   /// @brief Query and initilise issue from id.
   ///
@@ -68,6 +70,9 @@ struct issue {
   /// @return The constructed json::object.
   json::object jsonify() const;
 
+  /// @brief Fields bound to the keys of a JSON object.
+  static const std::vector<bind::field<issue>> &fields();
+
   uint32_t id;
   std::string subject;
   std::string description;
@@ -88,8 +93,14 @@ struct issue {
   reference category;
 
   struct journal {
+    /// @brief Fields bound to the keys of a JSON object.
+    static const std::vector<bind::field<journal>> &fields();
+
     std::string created_on;
     struct detail {
+      /// @brief Fields bound to the keys of a JSON object.
+      static const std::vector<bind::field<detail>> &fields();
+
       std::string name;
       std::string new_value;
       std::string old_value;
@@ -98,7 +109,9 @@ struct issue {
     uint32_t id;
     std::string notes;
     reference user;
+    std::vector<detail> details;
   };
+  // NOTE: Only present when the issue is requested with include=journals.
   std::vector<journal> journals;
 
   // TODO: Custom fields?
@@ -135,6 +148,23 @@ namespace query {
 result issues(std::string &filter, redmine::config &config,
               redmine::options &options, std::vector<issue> &issues);
 
+/// @brief Query issues, reading each as soon as its page arrives.
+///
+/// Only the page being read is held in memory while the following pages are
+/// still in flight.
+///
+/// @param filter Query string of the issues, may be empty.
+/// @param config The users redmine configuration.
+/// @param options Enabled options.
+/// @param row Reads an issue, the issue may be moved from. Issues are no
+/// longer read once it fails.
+///
+/// @return Return redmine::SUCCESS if all issues were read, or the first
+/// error otherwise.
+result issues(const std::string &filter, redmine::config &config,
+              redmine::options &options,
+              const std::function<result(redmine::issue &issue)> &row);
+
 result issue_statuses(redmine::config &config, redmine::options &options,
                       std::vector<issue_status> &issue_statuses);
 
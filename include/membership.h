@@ -28,7 +28,10 @@ namespace redmine {
 struct membership {
   membership();
 
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
+
+  static const std::vector<bind::field<membership>> &fields();
 
   uint32_t id;
   reference project;
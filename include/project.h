@@ -34,18 +34,22 @@ struct project {
   /// @brief Default constructor.
   project();
 
-  /// @brief Initialise from a json::object.
+  /// @brief Initialise from a json::object or a json::node of a json::tape.
   ///
   /// @param object Object to initilise redmine::project with.
   ///
   /// @return Returns either redmine::SUCCESS or redmine::FAILURE.
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
 
   /// @brief Construct a json::object from this redmine::project.
   ///
   /// @return The constructed json::object.
   json::object jsonify() const;
 
+  /// @brief Fields bound to the keys of a JSON object.
+  static const std::vector<bind::field<project>> &fields();
+
   /// @brief Equality operator for redmine::project.
   ///
   /// @param other Another redmine::project object.
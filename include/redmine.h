@@ -30,8 +30,15 @@
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 namespace redmine {
+namespace bind {
+// NOTE: Defined in bind.h.
+template <class Struct>
+struct field;
+}  // bind
+
 /// @brief Enumeration of all possible result codes.
 enum result {
   SUCCESS,
@@ -45,7 +52,7 @@ enum result {
 /// @brief Object encapsulating all command line options.
 struct options {
   /// @brief Default constructor.
-  options() : help(), verbose(), debug(), debug_http() {}
+  options() : help(), verbose(), debug(), debug_http(), timings() {}
 
   /// @breif Option to display help output.
   bool help;
@@ -59,16 +66,22 @@ struct options {
   /// the http connection because the servers response header will be inserted
   /// into the body of the packet invalidating json data.
   bool debug_http;
+  /// @brief Option to print request and parse timings once finished.
+  bool timings;
 };
 
 /// @brief Common pattern used to reference a redmine item.
 struct reference {
-  /// @brief Initialise from a json::object.
+  /// @brief Initialise from a json::object or a json::node of a json::tape.
   ///
   /// @param object Object to initialise redmine::reference from.
   ///
   /// @return Returns either redmine::SUCCESS or redmine::FAILURE.
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
+
+  /// @brief Fields bound to the keys of a JSON object.
+  static const std::vector<bind::field<reference>> &fields();
 
   /// @brief The items unique ID number.
   uint32_t id;
@@ -23,166 +23,118 @@
 
 #include <config.h>
 
+#include <bitset>
+
+// NOTE: The permissions a role may grant, the enumerator and the name the
+// server uses for each. Expand with a PERMISSION(ENUM, NAME) macro.
+#define REDMINE_PERMISSIONS(PERMISSION)                                    \
+  /* Project */                                                            \
+  PERMISSION(ADD_PROJECT, add_project)                                     \
+  PERMISSION(EDIT_PROJECT, edit_project)                                   \
+  PERMISSION(CLOSE_PROJECT, close_project)                                 \
+  PERMISSION(SELECT_PROJECT_MODULES, select_project_modules)               \
+  PERMISSION(MANAGE_MEMBERS, manage_members)                               \
+  PERMISSION(MANAGE_VERSIONS, manage_versions)                             \
+  PERMISSION(ADD_SUBPROJECTS, add_subprojects)                             \
+  /* Issue */                                                              \
+  PERMISSION(MANAGE_CATEGORIES, manage_categories)                         \
+  PERMISSION(VIEW_ISSUES, view_issues)                                     \
+  PERMISSION(ADD_ISSUES, add_issues)                                       \
+  PERMISSION(EDIT_ISSUES, edit_issues)                                     \
+  PERMISSION(MANAGE_ISSUE_RELATIONS, manage_issue_relations)               \
+  PERMISSION(MANAGE_SUBTASKS, manage_subtasks)                             \
+  PERMISSION(SET_ISSUES_PRIVATE, set_issues_private)                       \
+  PERMISSION(SET_OWN_ISSUES_PRIVATE, set_own_issues_private)               \
+  PERMISSION(ADD_ISSUE_NOTES, add_issue_notes)                             \
+  PERMISSION(EDIT_ISSUE_NOTES, edit_issue_notes)                           \
+  PERMISSION(EDIT_OWN_ISSUE_NOTES, edit_own_issue_notes)                   \
+  PERMISSION(VIEW_PRIVATE_NOTES, view_private_notes)                       \
+  PERMISSION(SET_NOTES_PRIVATE, set_notes_private)                         \
+  PERMISSION(MOVE_ISSUES, move_issues)                                     \
+  PERMISSION(DELETE_ISSUES, delete_issues)                                 \
+  PERMISSION(MANAGE_PUBLIC_QUERIES, manage_public_queries)                 \
+  PERMISSION(SAVE_QUERIES, save_queries)                                   \
+  PERMISSION(VIEW_ISSUE_WATCHERS, view_issue_watchers)                     \
+  PERMISSION(ADD_ISSUE_WATCHERS, add_issue_watchers)                       \
+  PERMISSION(DELETE_ISSUE_WATCHERS, delete_issue_watchers)                 \
+  /* Time Tracking */                                                      \
+  PERMISSION(LOG_TIME, log_time)                                           \
+  PERMISSION(VIEW_TIME_ENTRIES, view_time_entries)                         \
+  PERMISSION(EDIT_TIME_ENTRIES, edit_time_entries)                         \
+  PERMISSION(EDIT_OWN_TIME_ENTRIES, edit_own_time_entries)                 \
+  PERMISSION(MANAGE_PROJECT_ACTIVITIES, manage_project_activities)         \
+  /* News */                                                               \
+  PERMISSION(MANAGE_NEWS, manage_news)                                     \
+  PERMISSION(COMMENT_NEWS, comment_news)                                   \
+  /* Document */                                                           \
+  PERMISSION(ADD_DOCUMENTS, add_documents)                                 \
+  PERMISSION(EDIT_DOCUMENTS, edit_documents)                               \
+  PERMISSION(DELETE_DOCUMENTS, delete_documents)                           \
+  PERMISSION(VIEW_DOCUMENTS, view_documents)                               \
+  /* File */                                                               \
+  PERMISSION(MANAGE_FILES, manage_files)                                   \
+  PERMISSION(VIEW_FILES, view_files)                                       \
+  /* Wiki */                                                               \
+  PERMISSION(MANAGE_WIKI, manage_wiki)                                     \
+  PERMISSION(RENAME_WIKI_PAGES, rename_wiki_pages)                         \
+  PERMISSION(DELETE_WIKI_PAGES, delete_wiki_pages)                         \
+  PERMISSION(VIEW_WIKI_PAGES, view_wiki_pages)                             \
+  PERMISSION(EXPORT_WIKI_PAGES, export_wiki_pages)                         \
+  PERMISSION(VIEW_WIKI_EDITS, view_wiki_edits)                             \
+  PERMISSION(EDIT_WIKI_PAGES, edit_wiki_pages)                             \
+  PERMISSION(DELETE_WIKI_PAGES_ATTACHMENTS, delete_wiki_pages_attachments) \
+  PERMISSION(PROTECT_WIKI_PAGES, protect_wiki_pages)                       \
+  /* Repository */                                                         \
+  PERMISSION(MANAGE_REPOSITORY, manage_repository)                         \
+  PERMISSION(BROWSE_REPOSITORY, browse_repository)                         \
+  PERMISSION(VIEW_CHANGESETS, view_changesets)                             \
+  PERMISSION(COMMIT_ACCESS, commit_access)                                 \
+  PERMISSION(MANAGE_RELATED_ISSUES, manage_related_issues)                 \
+  /* Forum */                                                              \
+  PERMISSION(MANAGE_BOARDS, manage_boards)                                 \
+  PERMISSION(ADD_MESSAGES, add_messages)                                   \
+  PERMISSION(EDIT_MESSAGES, edit_messages)                                 \
+  PERMISSION(EDIT_OWN_MESSAGES, edit_own_messages)                         \
+  PERMISSION(DELETE_MESSAGES, delete_messages)                             \
+  PERMISSION(DELETE_OWN_MESSAGES, delete_own_messages)                     \
+  /* Calendar */                                                           \
+  PERMISSION(VIEW_CALENDAR, view_calendar)                                 \
+  /* Gantt */                                                              \
+  PERMISSION(VIEW_GANTT, view_gantt)
+
 namespace redmine {
 enum permisson {
-  ADD_PROJECT,
-  EDIT_PROJECT,
-  CLOSE_PROJECT,
-  SELECT_PROJECT_MODULES,
-  MANAGE_MEMBERS,
-  MANAGE_VERSIONS,
-  ADD_SUBPROJECTS,
-  MANAGE_CATEGORIES,
-  VIEW_ISSUES,
-  ADD_ISSUES,
-  EDIT_ISSUES,
-  MANAGE_ISSUE_RELATIONS,
-  MANAGE_SUBTASKS,
-  SET_ISSUES_PRIVATE,
-  SET_OWN_ISSUES_PRIVATE,
-  ADD_ISSUE_NOTES,
-  EDIT_ISSUE_NOTES,
-  EDIT_OWN_ISSUE_NOTES,
-  VIEW_PRIVATE_NOTES,
-  SET_NOTES_PRIVATE,
-  MOVE_ISSUES,
-  DELETE_ISSUES,
-  MANAGE_PUBLIC_QUERIES,
-  SAVE_QUERIES,
-  VIEW_ISSUE_WATCHERS,
-  ADD_ISSUE_WATCHERS,
-  DELETE_ISSUE_WATCHERS,
-  LOG_TIME,
-  VIEW_TIME_ENTRIES,
-  EDIT_TIME_ENTRIES,
-  EDIT_OWN_TIME_ENTRIES,
-  MANAGE_PROJECT_ACTIVITIES,
-  MANAGE_NEWS,
-  COMMENT_NEWS,
-  ADD_DOCUMENTS,
-  EDIT_DOCUMENTS,
-  DELETE_DOCUMENTS,
-  VIEW_DOCUMENTS,
-  MANAGE_FILES,
-  VIEW_FILES,
-  MANAGE_WIKI,
-  RENAME_WIKI_PAGES,
-  DELETE_WIKI_PAGES,
-  VIEW_WIKI_PAGES,
-  EXPORT_WIKI_PAGES,
-  VIEW_WIKI_EDITS,
-  EDIT_WIKI_PAGES,
-  DELETE_WIKI_PAGES_ATTACHMENTS,
-  PROTECT_WIKI_PAGES,
-  MANAGE_REPOSITORY,
-  BROWSE_REPOSITORY,
-  VIEW_CHANGESETS,
-  COMMIT_ACCESS,
-  MANAGE_RELATED_ISSUES,
-  MANAGE_BOARDS,
-  ADD_MESSAGES,
-  EDIT_MESSAGES,
-  EDIT_OWN_MESSAGES,
-  DELETE_MESSAGES,
-  DELETE_OWN_MESSAGES,
-  VIEW_CALENDAR,
-  VIEW_GANTT,
+#define PERMISSION(ENUM, NAME) ENUM,
+  REDMINE_PERMISSIONS(PERMISSION)
+#undef PERMISSION
+  PERMISSION_COUNT,
 };
 
 struct permissions {
   permissions();
 
+  result init(const json::object &object);
+
+  /// @brief Write the role in the form read by init.
+  json::object jsonify() const;
+
   result get(const uint32_t role, const redmine::config &config,
              redmine::options &options);
 
   permissions &operator|=(const permissions &other);
 
-  uint32_t id;
-  std::string name;
-
-  // Project
-  bool add_project;
-  bool edit_project;
-  bool close_project;
-  bool select_project_modules;
-  bool manage_members;
-  bool manage_versions;
-  bool add_subprojects;
-
-  // Issue
-  bool manage_categories;
-  bool view_issues;
-  bool add_issues;
-  bool edit_issues;
-  bool manage_issue_relations;
-  bool manage_subtasks;
-  bool set_issues_private;
-  bool set_own_issues_private;
-  bool add_issue_notes;
-  bool edit_issue_notes;
-  bool edit_own_issue_notes;
-  bool view_private_notes;
-  bool set_notes_private;
-  bool move_issues;
-  bool delete_issues;
-  bool manage_public_queries;
-  bool save_queries;
-  bool view_issue_watchers;
-  bool add_issue_watchers;
-  bool delete_issue_watchers;
-
-  // Time Tracking
-  bool log_time;
-  bool view_time_entries;
-  bool edit_time_entries;
-  bool edit_own_time_entries;
-  bool manage_project_activities;
+  /// @brief Check if the permission is granted.
+  bool has(redmine::permisson permisson) const;
 
-  // News
-  bool manage_news;
-  bool comment_news;
+  /// @brief Find a permission by the name the server uses for it.
+  ///
+  /// @return Returns redmine::PERMISSION_COUNT for unknown names.
+  static redmine::permisson find(const char *name, size_t size);
 
-  // Document
-  bool add_documents;
-  bool edit_documents;
-  bool delete_documents;
-  bool view_documents;
-
-  // File
-  bool manage_files;
-  bool view_files;
-
-  // Wiki
-  bool manage_wiki;
-  bool rename_wiki_pages;
-  bool delete_wiki_pages;
-  bool view_wiki_pages;
-  bool export_wiki_pages;
-  bool view_wiki_edits;
-  bool edit_wiki_pages;
-  bool delete_wiki_pages_attachments;
-  bool protect_wiki_pages;
-
-  // Repository
-  bool manage_repository;
-  bool browse_repository;
-  bool view_changesets;
-  bool commit_access;
-  bool manage_related_issues;
-
-  // Forum
-  bool manage_boards;
-  bool add_messages;
-  bool edit_messages;
-  bool edit_own_messages;
-  bool delete_messages;
-  bool delete_own_messages;
-
-  // Calendar
-  bool view_calendar;
-
-  // Gantt
-  bool view_gantt;
+  uint32_t id;
+  std::string name;
+  /// @brief Granted permissions indexed by redmine::permisson.
+  std::bitset<PERMISSION_COUNT> granted;
 };
 
 namespace query {
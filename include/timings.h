@@ -0,0 +1,108 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef REDMINE_TIMINGS_H
+#define REDMINE_TIMINGS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace redmine {
+namespace timings {
+/// @brief Timing of a single HTTP request, durations are in seconds.
+struct request {
+  /// @brief Default constructor.
+  request();
+
+  /// @brief The HTTP method.
+  const char *method;
+  /// @brief The path of the URL requested.
+  std::string path;
+  /// @brief The response status.
+  uint32_t status;
+  /// @brief Number of response body bytes received.
+  uint64_t bytes;
+  /// @brief Time spent resolving the host name.
+  double dns;
+  /// @brief Time spent establishing the TCP connection.
+  double connect;
+  /// @brief Time spent in the TLS handshake.
+  double tls;
+  /// @brief Time from the start of the request until the first byte arrived.
+  double ttfb;
+  /// @brief Total time of the request.
+  double total;
+};
+
+/// @brief Enable recording of timings, disabled by default.
+void enable();
+
+/// @brief Check if recording of timings is enabled.
+bool enabled();
+
+/// @brief Record the timing of a HTTP request.
+///
+/// @param request The request timing to record.
+void record(const request &request);
+
+/// @brief Add elapsed time to a named section of client side work.
+///
+/// @param section Name of the section, must outlive the program.
+/// @param seconds Elapsed time to add.
+void record(const char *section, const double seconds);
+
+/// @brief Scoped timer adding its lifetime to a named section.
+class scope {
+ public:
+  /// @brief Start the timer if timings are enabled.
+  ///
+  /// @param section Name of the section, must outlive the program.
+  scope(const char *section);
+
+  /// @brief Stop the timer and record the section.
+  ~scope();
+
+ private:
+  scope(const scope &) = delete;
+  scope &operator=(const scope &) = delete;
+
+  const char *section;
+  std::chrono::steady_clock::time_point start;
+};
+
+/// @brief Call a function, recording the time taken under a named section.
+///
+/// @param section Name of the section, must outlive the program.
+/// @param function The function to call.
+///
+/// @return Returns the result of the function.
+template <class Function>
+auto time(const char *section, Function function) -> decltype(function()) {
+  scope timing(section);
+  return function();
+}
+
+/// @brief Print all recorded timings to stderr.
+void print();
+}  // timings
+}  // redmine
+
+#endif  // REDMINE_TIMINGS_H
@@ -33,9 +33,12 @@ namespace redmine {
 struct user {
   user();
 
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
 
-  json::object jsonify();
+  json::object jsonify() const;
+
+  static const std::vector<bind::field<user>> &fields();
 
   uint32_t id;
   std::string firstname;
@@ -52,10 +55,26 @@ struct user {
 struct current_user {
   current_user();
 
+  /// @brief Request the user and their memberships, permissions are not
+  /// resolved.
   result get(redmine::config &config, redmine::options &options);
 
+  /// @brief Resolve the permissions of the roles of each membership.
+  ///
+  /// Nothing is requested when no permission is checked, roles which are
+  /// not cached are not requested when the cached roles grant every checked
+  /// permission.
+  ///
+  /// @param checked The permissions which will be checked.
+  result resolve(redmine::config &config, redmine::options &options,
+                 const std::bitset<redmine::PERMISSION_COUNT> &checked);
+
+  /// @brief Check a permission, requires resolve to have been called with
+  /// the permission checked.
   bool can(redmine::permisson permisson);
 
+  static const std::vector<bind::field<current_user>> &fields();
+
   uint32_t id;
   std::string login;
   std::string firstname;
@@ -65,10 +84,14 @@ struct current_user {
   std::string last_login_on;
   uint32_t status;  // NOTE: Only the admin can see this.
   struct membership {
+    static const std::vector<bind::field<membership>> &fields();
+
     reference project;
     std::vector<reference> roles;
   };
   std::vector<membership> memberships;
+  // NOTE: Roles which are skipped by resolve are left out, only the bits of
+  // the permissions which were checked are meaningful.
   std::unordered_map<uint32_t, redmine::permissions> project_permissions;
   redmine::permissions permissions;
 };
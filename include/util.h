@@ -30,6 +30,8 @@ namespace util {
 std::string getcwd();
 
 result rm(const std::string &filename);
+
+result mkdir(const std::string &path);
 }
 }
 
@@ -28,7 +28,10 @@ namespace redmine {
 struct version {
   version();
 
-  result init(const json::object &object);
+  template <typename Object>
+  result init(const Object &object);
+
+  static const std::vector<bind::field<version>> &fields();
 
   uint32_t id;
   std::string name;
@@ -0,0 +1,118 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <cache.h>
+#include <util.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace redmine {
+namespace cache {
+entry::entry() : etag(), last_modified(), time(0), body() {}
+
+static std::string cache_path(const redmine::config &config) {
+  std::string path;
+#if defined(REDMINE_PLATFORM_LINUX)
+  const char *xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+  if (xdg_cache_home && *xdg_cache_home) {
+    path = xdg_cache_home;
+  } else {
+    path = std::getenv("HOME");
+    path += "/.cache";
+  }
+  path += "/redmine/";
+#elif defined(REDMINE_PLATFORM_MAC)
+  path = std::getenv("HOME");
+  path += "/Library/Caches/redmine/";
+#elif defined(REDMINE_PLATFORM_WINDOWS)
+  path = std::getenv("HOME");
+  path += "\\AppData\\Local\\redmine\\cache\\";
+#endif
+  return path + config.current->name;
+}
+
+/// @brief Name the cache file of a URL with its 64-bit FNV-1a hash.
+static std::string entry_path(const redmine::config &config,
+                              const std::string &url) {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : url) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.cache",
+                static_cast<unsigned long long>(hash));
+#if defined(REDMINE_PLATFORM_WINDOWS)
+  return cache_path(config) + "\\" + name;
+#else
+  return cache_path(config) + "/" + name;
+#endif
+}
+
+result load(const redmine::config &config, const std::string &url,
+            entry &entry) {
+  std::ifstream file(entry_path(config, url), std::ios::binary);
+  CHECK(!file.is_open(), return FAILURE);
+
+  // NOTE: The first line holds the URL to detect hash collisions.
+  std::string line;
+  CHECK(!std::getline(file, line) || line != url, return FAILURE);
+  CHECK(!std::getline(file, entry.etag), return FAILURE);
+  CHECK(!std::getline(file, entry.last_modified), return FAILURE);
+  CHECK(!std::getline(file, line), return FAILURE);
+  entry.time = std::strtoull(line.c_str(), nullptr, 10);
+  entry.body.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+
+  return SUCCESS;
+}
+
+result store(const redmine::config &config, const std::string &url,
+             const entry &entry) {
+  CHECK_RETURN(util::mkdir(cache_path(config)));
+
+  // NOTE: Write to a temporary file first so that readers never observe a
+  // partially written entry.
+  std::string path = entry_path(config, url);
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    CHECK(!file.is_open(), return FAILURE);
+    file << url << "\n"
+         << entry.etag << "\n"
+         << entry.last_modified << "\n"
+         << entry.time << "\n"
+         << entry.body;
+    CHECK(!file, return FAILURE);
+  }
+#if defined(REDMINE_PLATFORM_WINDOWS)
+  std::remove(path.c_str());
+#endif
+  CHECK(std::rename(temporary.c_str(), path.c_str()),
+        std::remove(temporary.c_str());
+        return FAILURE);
+
+  return SUCCESS;
+}
+}  // cache
+}  // redmine
@@ -19,6 +19,7 @@
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <config.h>
+#include <timings.h>
 
 #include <json/json.hpp>
 
@@ -58,7 +59,17 @@ redmine::config::config()
       current(nullptr) {}
 
 redmine::config::profile::profile()
-    : name(), url(), key(), port(80), use_ssl(), verify_ssl() {}
+    : name(),
+      url(),
+      key(),
+      port(80),
+      use_ssl(),
+      verify_ssl(),
+      concurrency(4),
+      cache_max_age(0),
+      permissions_max_age(24 * 60 * 60),
+      retries(3),
+      retry_delay(500) {}
 
 redmine::result redmine::config::save() {
   std::ofstream file(config_path());
@@ -72,27 +83,33 @@ redmine::result redmine::config::save() {
     Profile.add("port", profile.port);
     Profile.add("use_ssl", profile.use_ssl);
     Profile.add("verify_ssl", profile.verify_ssl);
-    Profiles.append(Profile);
+    Profile.add("concurrency", profile.concurrency);
+    Profile.add("cache_max_age", profile.cache_max_age);
+    Profile.add("permissions_max_age", profile.permissions_max_age);
+    Profile.add("retries", profile.retries);
+    Profile.add("retry_delay", profile.retry_delay);
+    Profiles.append(std::move(Profile));
   }
   json::object Config;
   Config.add("browser", browser);
   Config.add("editor", editor);
   Config.add("profile_name", profile_name);
-  Config.add("profiles", Profiles);
+  Config.add("profiles", std::move(Profiles));
   file << json::write(Config, "  ");
   return SUCCESS;
 }
 
 redmine::result redmine::config::load(redmine::options &options) {
   std::string path(config_path());
-  std::ifstream file(path);
-  CHECK(!file.is_open(), fprintf(stderr, "could not open: %s\n", path.c_str());
+  CHECK(!std::ifstream(path).is_open(),
+        fprintf(stderr, "could not open: %s\n", path.c_str());
         return INVALID_CONFIG);
-  std::string str((std::istreambuf_iterator<char>(file)),
-                  std::istreambuf_iterator<char>());
-  auto Root = json::read(str);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+  auto Root = timings::time("json::read_file",
+                            [&] { return json::read_file(path); });
+  CHECK(json::TYPE_OBJECT != Root.type(),
+        fprintf(stderr, "invalid config: %s\n", path.c_str());
+        return INVALID_CONFIG);
+  CHECK(options.debug, json::write(Root, stdout, "  "); printf("\n"));
 
   // TODO: Properly handle missing config file with interactive creation.
 
@@ -147,6 +164,36 @@ redmine::result redmine::config::load(redmine::options &options) {
       profile.verify_ssl = VerifySsl->boolean();
     }
 
+    auto Concurrency = Profile.object().get("concurrency");
+    if (Concurrency) {
+      CHECK_JSON_TYPE(*Concurrency, json::TYPE_NUMBER);
+      profile.concurrency = Concurrency->number<uint32_t>();
+    }
+
+    auto CacheMaxAge = Profile.object().get("cache_max_age");
+    if (CacheMaxAge) {
+      CHECK_JSON_TYPE(*CacheMaxAge, json::TYPE_NUMBER);
+      profile.cache_max_age = CacheMaxAge->number<uint32_t>();
+    }
+
+    auto PermissionsMaxAge = Profile.object().get("permissions_max_age");
+    if (PermissionsMaxAge) {
+      CHECK_JSON_TYPE(*PermissionsMaxAge, json::TYPE_NUMBER);
+      profile.permissions_max_age = PermissionsMaxAge->number<uint32_t>();
+    }
+
+    auto Retries = Profile.object().get("retries");
+    if (Retries) {
+      CHECK_JSON_TYPE(*Retries, json::TYPE_NUMBER);
+      profile.retries = Retries->number<uint32_t>();
+    }
+
+    auto RetryDelay = Profile.object().get("retry_delay");
+    if (RetryDelay) {
+      CHECK_JSON_TYPE(*RetryDelay, json::TYPE_NUMBER);
+      profile.retry_delay = RetryDelay->number<uint32_t>();
+    }
+
     profiles.push_back(profile);
   }
 
@@ -27,13 +27,11 @@ namespace redmine {
 static result query_enumerations(const std::string &enum_name, config &config,
                                  redmine::options &options,
                                  std::vector<redmine::enumeration> &enums) {
-  std::string body;
-  CHECK_RETURN(
-      http::get("/enumerations/" + enum_name + ".json", config, options, body));
-
-  auto Root = json::read(body, false);
+  json::value Root;
+  CHECK_RETURN(http::get("/enumerations/" + enum_name + ".json", config,
+                         options, Root, http::CACHED));
   CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+  CHECK(options.debug, json::write(Root, stdout, "  "); printf("\n"));
 
   auto Enums = Root.object().get(enum_name);
   CHECK_JSON_PTR(Enums, json::TYPE_ARRAY);
@@ -18,12 +18,21 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <cache.h>
 #include <http.h>
 #include <redmine.h>
+#include <timings.h>
 
 #include <curl/curl.h>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstring>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <thread>
 
 namespace redmine {
 result print_curl_error(CURLcode error, const char *file, const int line);
@@ -33,28 +42,83 @@ result print_curl_error(CURLcode error, const char *file, const int line);
   }
 result print_http_error(const http::status error);
 
+/// @brief The session all requests are routed through, set by session::init.
+static http::session *active = nullptr;
+
+http::session::session()
+    : handle(nullptr),
+      share(nullptr),
+      header(nullptr),
+      url(),
+      key(),
+      multi(nullptr),
+      handles(),
+      responses() {}
+
 redmine::result redmine::http::session::init() {
   CURL_CHECK_RETURN(curl_global_init(CURL_GLOBAL_ALL));
+
+  share = curl_share_init();
+  CHECK(!share, fprintf(stderr, "curl share init failed\n"); return FAILURE);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+
+  handle = curl_easy_init();
+  CHECK(!handle, fprintf(stderr, "curl init failed\n"); return FAILURE);
+
+  multi = curl_multi_init();
+  CHECK(!multi, fprintf(stderr, "curl multi init failed\n"); return FAILURE);
+
+  active = this;
   return SUCCESS;
 }
 
-http::session::~session() { curl_global_cleanup(); }
-
-struct curl_raii {
-  curl_raii() : handle(curl_easy_init()) {}
+redmine::result redmine::http::session::prepare(const config &config) {
+  if (header && url == config.current->url && key == config.current->key) {
+    return SUCCESS;
+  }
 
-  ~curl_raii() {
-    if (handle) {
-      curl_easy_cleanup(handle);
-    }
+  if (header) {
+    curl_slist_free_all(header);
+    header = nullptr;
   }
 
-  bool valid() { return handle != nullptr; }
+  url = config.current->url;
+  key = config.current->key;
 
-  operator CURL *() { return handle; }
+  std::string api_key_header("X-Redmine-API-Key: ");
+  api_key_header += key;
+  header = curl_slist_append(header, api_key_header.c_str());
+  CHECK(!header, fprintf(stderr, "curl header init failed\n"); return FAILURE);
+  header = curl_slist_append(header, "Content-Type: application/json");
 
-  CURL *handle;
-};
+  return SUCCESS;
+}
+
+http::session::~session() {
+  if (active == this) {
+    active = nullptr;
+  }
+  if (header) {
+    curl_slist_free_all(header);
+  }
+  for (auto curl : handles) {
+    curl_easy_cleanup(curl);
+  }
+  if (multi) {
+    curl_multi_cleanup(multi);
+  }
+  if (handle) {
+    curl_easy_cleanup(handle);
+  }
+  if (share) {
+    curl_share_cleanup(share);
+  }
+  curl_global_cleanup();
+}
 
 struct read_state {
   read_state(const std::string &str) : str(str), index(0) {}
@@ -84,27 +148,65 @@ size_t write(void *ptr, size_t size, size_t count, void *data) {
   return bytes;
 }
 
-struct curl_slist *create_header(const config &config, size_t length = 0) {
-  struct curl_slist *header = nullptr;
-  std::string api_key_header("X-Redmine-API-Key: ");
-  api_key_header += config.current->key;
-  header = curl_slist_append(header, api_key_header.c_str());
-  header = curl_slist_append(header, "Content-Type: application/json");
-  if (length) {
-    std::string content_length("Content-Length: ");
-    content_length += std::to_string(length);
-    header = curl_slist_append(header, content_length.c_str());
+/// @brief Response headers of interest captured during a transfer.
+struct response_headers {
+  std::string etag;
+  std::string last_modified;
+  std::string retry_after;
+};
+
+size_t header(char *ptr, size_t size, size_t count, void *data) {
+  response_headers *headers = static_cast<response_headers *>(data);
+  const size_t bytes = size * count;
+  std::string line(ptr, bytes);
+  size_t colon = line.find(':');
+  if (std::string::npos == colon) {
+    return bytes;
+  }
+  std::string name = line.substr(0, colon);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  size_t begin = line.find_first_not_of(" \t", colon + 1);
+  size_t end = line.find_last_not_of(" \t\r\n");
+  std::string value;
+  if (std::string::npos != begin && begin <= end) {
+    value = line.substr(begin, end - begin + 1);
   }
-  return header;
+  if ("etag" == name) {
+    headers->etag = value;
+  } else if ("last-modified" == name) {
+    headers->last_modified = value;
+  } else if ("retry-after" == name) {
+    headers->retry_after = value;
+  }
+  return bytes;
 }
 
+/// @brief Check there is an active session and prepare it for the profile.
+result prepare_session(const redmine::config &config) {
+  CHECK(!active, fprintf(stderr, "http session not initialised\n");
+        return FAILURE);
+  CHECK_RETURN(active->prepare(config));
+  return SUCCESS;
+}
+
+/// @brief Reset an easy handle of the active session and apply common options.
+///
+/// Resetting the handle clears all options from the previous request but keeps
+/// live connections, the DNS cache and the TLS session cache intact.
 result set_options(CURL *curl, const std::string &path,
                    const redmine::config &config, redmine::options &options) {
-  std::string url = config.current->url + path;
+  curl_easy_reset(curl);
+
+  std::string url = active->url + path;
   CHECK(options.debug, printf("%s\n", url.c_str()));
   CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_URL, url.c_str()));
-  auto header = create_header(config);
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header));
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HTTPHEADER, active->header));
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_SHARE, active->share));
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L));
+  // NOTE: An empty string offers every encoding libcurl supports, e.g. gzip,
+  // deflate and br, responses are then decoded chunk by chunk before they
+  // reach the write callback.
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""));
   if (config.current->use_ssl) {
     CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_USE_SSL, CURLUSESSL_ALL));
     CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER,
@@ -117,19 +219,324 @@ result set_options(CURL *curl, const std::string &path,
   return SUCCESS;
 }
 
+/// @brief Upper bound of the delay between two attempts in milliseconds.
+static const uint64_t max_retry_delay = 60000;
+
+/// @brief Check if a failed attempt is worth retrying.
+static bool transient(const CURLcode code, const http::status status) {
+  switch (code) {
+    case CURLE_OK:
+      break;
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+      return true;
+    default:
+      return false;
+  }
+  switch (status) {
+    case http::code::REQUEST_TIMEOUT:
+    case http::code::TOO_MANY_REQUESTS:
+    case http::code::BAD_GATEWAY:
+    case http::code::SERVICE_UNAVAILABLE:
+    case http::code::GATEWAY_TIMEOUT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// @brief Milliseconds to wait before retrying.
+///
+/// The server's Retry-After, either delay seconds or an HTTP date, is honoured
+/// when present. Otherwise the delay grows exponentially with each attempt
+/// and is jittered so that concurrent clients do not retry in lockstep.
+static uint64_t retry_delay(const config &config, const uint32_t attempt,
+                            const std::string &retry_after) {
+  if (!retry_after.empty()) {
+    char *end = nullptr;
+    uint64_t seconds = std::strtoull(retry_after.c_str(), &end, 10);
+    if ('\0' != *end) {
+      time_t date = curl_getdate(retry_after.c_str(), nullptr);
+      time_t now = std::time(nullptr);
+      seconds = (-1 != date && date > now) ? date - now : 0;
+    }
+    return std::min(seconds * 1000, max_retry_delay);
+  }
+  uint64_t delay = std::min<uint64_t>(
+      uint64_t(config.current->retry_delay) << std::min(attempt, 16u),
+      max_retry_delay);
+  static std::mt19937 engine{std::random_device{}()};
+  std::uniform_int_distribution<uint64_t> jitter(delay / 2, delay);
+  return jitter(engine);
+}
+
+/// @brief Wait before the next attempt of a request.
+static void retry_wait(const config &config, redmine::options &options,
+                       const std::string &path, const uint32_t attempt,
+                       const CURLcode code, const http::status status,
+                       const std::string &retry_after) {
+  const uint64_t delay = retry_delay(config, attempt, retry_after);
+  CHECK(options.debug,
+        printf("retry %u/%u in %llums: %s: %s\n", attempt + 1,
+               config.current->retries, (unsigned long long)delay,
+               path.c_str(), CURLE_OK == code
+                                 ? std::to_string(status).c_str()
+                                 : curl_easy_strerror(code)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+}
+
+/// @brief Record the timing of a finished transfer if timings are enabled.
+static void record(CURL *curl, const char *method, const std::string &path) {
+  if (!timings::enabled()) {
+    return;
+  }
+  timings::request request;
+  request.method = method;
+  request.path = path;
+  long status = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+  request.status = static_cast<uint32_t>(status);
+  curl_off_t bytes = 0;
+  curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+  double dns = 0, connect = 0, tls = 0;
+  curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME, &dns);
+  curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect);
+  curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &tls);
+  curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &request.ttfb);
+  curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &request.total);
+  request.bytes = static_cast<uint64_t>(bytes);
+  // NOTE: libcurl reports times since the start of the transfer, convert the
+  // connection phases to durations. Reused connections report zero.
+  request.dns = dns;
+  request.connect = connect > dns ? connect - dns : 0;
+  request.tls = tls > connect ? tls - connect : 0;
+  timings::record(request);
+}
+
+/// @brief Feed response data to a parser, timed as client side work.
+static void feed(json::parser &parser, const char *data, const size_t size) {
+  timings::scope timing("json::parser");
+  parser.feed(data, size);
+}
+
+/// @brief Perform a request on the session handle, retrying transient
+/// failures of idempotent methods.
+///
+/// @param method The HTTP method, used for timings.
+/// @param setup Applies the request options to the handle before each
+/// attempt, the handle is reset by set_options so this must be complete.
+/// @param headers Response headers captured by setup, used for Retry-After.
+/// @param[out] status The response status of the last attempt.
+template <class Setup>
+static result perform(const char *method, const std::string &path,
+                      const config &config,
+                      redmine::options &options, response_headers &headers,
+                      http::status &status, Setup setup) {
+  CURL *curl = active->handle;
+  for (uint32_t attempt = 0;; attempt++) {
+    headers = response_headers();
+    CHECK_RETURN(setup(curl));
+    CURLcode code = curl_easy_perform(curl);
+    record(curl, method, path);
+    long response = 0;
+    if (CURLE_OK == code) {
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
+    }
+    status = static_cast<http::status>(response);
+    if (attempt < config.current->retries && transient(code, status)) {
+      retry_wait(config, options, path, attempt, code, status,
+                 headers.retry_after);
+      continue;
+    }
+    CURL_CHECK_RETURN(code);
+    return SUCCESS;
+  }
+}
+
+/// @brief State of a GET request shared by single and batched requests.
+struct transfer {
+  transfer(const std::string &path, const http::caching caching,
+           std::string &body)
+      : path(path),
+        body(body),
+        caching(caching),
+        cached(false),
+        entry(),
+        headers(),
+        header(nullptr),
+        request(nullptr),
+        parser(nullptr) {}
+
+  ~transfer() {
+    if (header) {
+      curl_slist_free_all(header);
+    }
+  }
+
+  /// @brief Discard the response of a failed attempt.
+  void reset() {
+    body.clear();
+    headers = response_headers();
+    if (header) {
+      curl_slist_free_all(header);
+      header = nullptr;
+    }
+    if (parser) {
+      parser->reset();
+    }
+  }
+
+  const std::string &path;
+  std::string &body;
+  http::caching caching;
+  /// @brief True when a cache entry for the request was loaded.
+  bool cached;
+  cache::entry entry;
+  response_headers headers;
+  /// @brief Request header list with conditional headers, if any.
+  struct curl_slist *header;
+  /// @brief The batch request this transfer belongs to, if any.
+  http::request *request;
+  /// @brief Parser fed the response body as it arrives, if any.
+  json::parser *parser;
+
+ private:
+  transfer(const transfer &) = delete;
+  transfer &operator=(const transfer &) = delete;
+};
+
+static uint64_t now() { return static_cast<uint64_t>(std::time(nullptr)); }
+
+/// @brief Load the cache entry of a transfer.
+///
+/// @return Returns true if the cached response is fresh enough to be used
+/// without making a request.
+static bool lookup(const config &config, transfer &transfer,
+                   redmine::options &options) {
+  if (http::CACHED != transfer.caching) {
+    return false;
+  }
+  transfer.cached =
+      !cache::load(config, active->url + transfer.path, transfer.entry);
+  if (transfer.cached &&
+      now() - transfer.entry.time < config.current->cache_max_age) {
+    CHECK(options.debug, printf("cache hit: %s\n", transfer.path.c_str()));
+    transfer.body = std::move(transfer.entry.body);
+    if (transfer.parser) {
+      feed(*transfer.parser, transfer.body.data(), transfer.body.size());
+    }
+    return true;
+  }
+  return false;
+}
+
+size_t write_json(char *ptr, size_t size, size_t count, void *data) {
+  transfer *state = static_cast<transfer *>(data);
+  const size_t bytes = size * count;
+  if (http::CACHED == state->caching) {
+    state->body.append(ptr, bytes);
+  }
+  // NOTE: Parse errors are reported once the transfer is complete, error
+  // responses are not required to be JSON.
+  feed(*state->parser, ptr, bytes);
+  return bytes;
+}
+
+static result setup_get(CURL *curl, transfer &transfer, const config &config,
+                        redmine::options &options) {
+  CHECK_RETURN(set_options(curl, transfer.path, config, options));
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HTTPGET, 1));
+  if (transfer.parser) {
+    CURL_CHECK_RETURN(
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_json));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer));
+  } else {
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write));
+    CURL_CHECK_RETURN(
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer.body));
+  }
+  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header));
+  CURL_CHECK_RETURN(
+      curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer.headers));
+  if (http::CACHED == transfer.caching && transfer.cached) {
+    // NOTE: Extend a copy of the session headers to revalidate the entry.
+    for (auto item = active->header; item; item = item->next) {
+      transfer.header = curl_slist_append(transfer.header, item->data);
+    }
+    if (!transfer.entry.etag.empty()) {
+      std::string if_none_match("If-None-Match: " + transfer.entry.etag);
+      transfer.header =
+          curl_slist_append(transfer.header, if_none_match.c_str());
+    }
+    if (!transfer.entry.last_modified.empty()) {
+      std::string if_modified_since("If-Modified-Since: " +
+                                    transfer.entry.last_modified);
+      transfer.header =
+          curl_slist_append(transfer.header, if_modified_since.c_str());
+    }
+    CURL_CHECK_RETURN(
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.header));
+  }
+  return SUCCESS;
+}
+
+/// @brief Serve HTTP 304 from, and store HTTP 200 in, the cache.
+///
+/// @param status The response status, HTTP 304 is replaced by HTTP 200.
+static void complete(const config &config, transfer &transfer,
+                     http::status &status, redmine::options &options) {
+  if (http::CACHED != transfer.caching) {
+    return;
+  }
+  const std::string url = active->url + transfer.path;
+  if (transfer.cached && http::code::NOT_MODIFIED == status) {
+    CHECK(options.debug, printf("not modified: %s\n", transfer.path.c_str()));
+    transfer.entry.time = now();
+    cache::store(config, url, transfer.entry);
+    transfer.body = std::move(transfer.entry.body);
+    if (transfer.parser) {
+      feed(*transfer.parser, transfer.body.data(), transfer.body.size());
+    }
+    status = http::code::OK;
+  } else if (http::code::OK == status) {
+    transfer.entry.etag = transfer.headers.etag;
+    transfer.entry.last_modified = transfer.headers.last_modified;
+    transfer.entry.time = now();
+    transfer.entry.body = transfer.body;
+    cache::store(config, url, transfer.entry);
+  }
+}
+
 result http::get(const std::string &path, const config &config,
-                 redmine::options &options, std::string &body) {
+                 redmine::options &options, std::string &body,
+                 const http::caching caching) {
   CHECK(options.debug, printf("%s\n", path.c_str()));
-  curl_raii curl;
-  CHECK(!curl.valid(), fprintf(stderr, "curl init failed\n"); return FAILURE);
-  CHECK_RETURN(set_options(curl, path, config, options));
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HTTPGET, 1));
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write));
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body));
+  CHECK_RETURN(prepare_session(config));
+  auto prefetched = active->responses.find(path);
+  if (active->responses.end() != prefetched) {
+    body = std::move(prefetched->second);
+    active->responses.erase(prefetched);
+    CHECK(options.debug, printf("body: %s\n", body.c_str()));
+    return SUCCESS;
+  }
 
-  CURL_CHECK_RETURN(curl_easy_perform(curl));
+  transfer transfer(path, caching, body);
+  if (lookup(config, transfer, options)) {
+    return SUCCESS;
+  }
+  auto setup = [&](CURL *curl) {
+    transfer.reset();
+    return setup_get(curl, transfer, config, options);
+  };
   http::status status;
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+  CHECK_RETURN(
+      perform("GET", path, config, options, transfer.headers, status, setup));
+  complete(config, transfer, status, options);
   CHECK(http::code::OK != status, print_http_error(status); return FAILURE);
 
   CHECK(options.debug, printf("body: %s\n", body.c_str()));
@@ -137,20 +544,452 @@ result http::get(const std::string &path, const config &config,
   return SUCCESS;
 }
 
+/// @brief Perform an HTTP GET request feeding the response body to a parser.
+static result get_parsed(const std::string &path, const config &config,
+                         redmine::options &options, json::parser &parser,
+                         const http::caching caching) {
+  CHECK(options.debug, printf("%s\n", path.c_str()));
+  CHECK_RETURN(prepare_session(config));
+  auto prefetched = active->responses.find(path);
+  if (active->responses.end() != prefetched) {
+    feed(parser, prefetched->second.data(), prefetched->second.size());
+    active->responses.erase(prefetched);
+  } else {
+    std::string body;
+    transfer transfer(path, caching, body);
+    transfer.parser = &parser;
+    if (!lookup(config, transfer, options)) {
+      auto setup = [&](CURL *curl) {
+        transfer.reset();
+        return setup_get(curl, transfer, config, options);
+      };
+      http::status status;
+      CHECK_RETURN(
+          perform("GET", path, config, options, transfer.headers, status,
+                  setup));
+      complete(config, transfer, status, options);
+      CHECK(http::code::OK != status, print_http_error(status);
+            return FAILURE);
+    }
+  }
+
+  bool parsed = false;
+  {
+    timings::scope timing("json::parser");
+    parsed = parser.finish();
+  }
+  if (!parsed) {
+    CHECK(options.debug, fprintf(stderr, "error: %zu:%zu: %s\n", parser.line(),
+                                 parser.column(), parser.error()));
+    return FAILURE;
+  }
+
+  return SUCCESS;
+}
+
+result http::get(const std::string &path, const config &config,
+                 redmine::options &options, json::value &value,
+                 const http::caching caching) {
+  json::parser parser;
+  CHECK_RETURN(get_parsed(path, config, options, parser, caching));
+  value = std::move(parser.value());
+  return SUCCESS;
+}
+
+result http::get(const std::string &path, const config &config,
+                 redmine::options &options, json::document &document,
+                 const http::caching caching) {
+  json::parser parser(&document.arena());
+  CHECK_RETURN(get_parsed(path, config, options, parser, caching));
+  document.root() = std::move(parser.value());
+  return SUCCESS;
+}
+
+result http::get(const std::string &path, const config &config,
+                 redmine::options &options, json::tape &tape,
+                 const http::caching caching) {
+  std::string body;
+  CHECK_RETURN(get(path, config, options, body, caching));
+  bool recorded = false;
+  {
+    timings::scope timing("json::tape");
+    recorded = json::read(std::move(body), tape, options.debug);
+  }
+  CHECK(!recorded, return FAILURE);
+  return SUCCESS;
+}
+
+result http::get(const std::string &path, const config &config,
+                 redmine::options &options, json::handler &handler,
+                 const http::caching caching) {
+  json::parser parser(handler);
+  return get_parsed(path, config, options, parser, caching);
+}
+
+http::request::request(const std::string &path, const http::caching caching)
+    : path(path), caching(caching), body(), status(0), error(SUCCESS) {}
+
+/// @brief Record the outcome of a finished batch request.
+static void finish_request(const CURLcode code, const http::status status,
+                           transfer &transfer, const config &config,
+                           redmine::options &options) {
+  http::request &request = *transfer.request;
+  request.error = print_curl_error(code, __FILE__, __LINE__);
+  if (request.error) {
+    return;
+  }
+  request.status = status;
+  complete(config, transfer, request.status, options);
+  CHECK(options.debug,
+        printf("%s\nbody: %s\n", request.path.c_str(), request.body.c_str()));
+  CHECK(http::code::OK != request.status, print_http_error(request.status);
+        request.error = FAILURE);
+}
+
+/// @brief Perform a batch of GET requests, see redmine::http::get.
+///
+/// @param window Optionally returns how many of the leading requests may be
+/// issued, those after it wait until it grows.
+/// @param cancelled Optionally returns true once the requests not yet
+/// finished are no longer wanted, transfers in flight are then abandoned and
+/// those requests fail without being completed.
+static result perform(std::vector<http::request> &requests,
+                      const config &config, redmine::options &options,
+                      const std::function<void(http::request &)> &complete,
+                      const std::function<size_t()> &window,
+                      const std::function<bool()> &cancelled) {
+  if (requests.empty()) {
+    return SUCCESS;
+  }
+  CHECK_RETURN(prepare_session(config));
+  std::vector<bool> reported(requests.size(), false);
+  auto finished = [&](http::request &request) {
+    reported[&request - requests.data()] = true;
+    if (complete) {
+      complete(request);
+    }
+  };
+  auto stop = [&] { return cancelled && cancelled(); };
+
+  std::vector<std::unique_ptr<transfer>> transfers;
+  transfers.reserve(requests.size());
+  for (auto &request : requests) {
+    transfers.emplace_back(
+        new transfer(request.path, request.caching, request.body));
+    transfers.back()->request = &request;
+  }
+
+  const size_t concurrency =
+      std::min<size_t>(std::max<uint32_t>(config.current->concurrency, 1),
+                       requests.size());
+  CURLM *multi = active->multi;
+  curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                    static_cast<long>(concurrency));
+
+  std::vector<transfer *> queue;
+  for (auto &transfer : transfers) {
+    queue.push_back(transfer.get());
+  }
+
+  // NOTE: Requests which failed transiently are retried together in the next
+  // round once the longest of their delays has elapsed.
+  bool stopped = false;
+  for (uint32_t attempt = 0; !queue.empty() && !stopped; attempt++) {
+    std::vector<transfer *> retry;
+    std::vector<CURL *> idle;
+    size_t used = 0;
+    size_t next = 0;
+    size_t pending = 0;
+
+    // NOTE: Handles of the session are only set up once they are needed, so
+    // requests served from the cache need no transfer at all.
+    auto acquire = [&]() -> CURL * {
+      if (!idle.empty()) {
+        CURL *curl = idle.back();
+        idle.pop_back();
+        return curl;
+      }
+      if (used == concurrency) {
+        return nullptr;
+      }
+      if (used == active->handles.size()) {
+        CURL *curl = curl_easy_init();
+        CHECK(!curl, return nullptr);
+        active->handles.push_back(curl);
+      }
+      return active->handles[used++];
+    };
+
+    auto submit = [&](CURL *curl, transfer &transfer) -> redmine::result {
+      CHECK_RETURN(setup_get(curl, transfer, config, options));
+      CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer));
+      CHECK(curl_multi_add_handle(multi, curl),
+            fprintf(stderr, "curl multi add failed\n"); return FAILURE);
+      return SUCCESS;
+    };
+
+    // NOTE: Issue queued requests while a handle is free and the window
+    // admits them.
+    auto fill = [&]() -> redmine::result {
+      while (next < queue.size() && !stop()) {
+        transfer &transfer = *queue[next];
+        if (window && static_cast<size_t>(transfer.request -
+                                          requests.data()) >= window()) {
+          break;
+        }
+        CURL *curl = acquire();
+        if (!curl) {
+          CHECK(used < concurrency,
+                fprintf(stderr, "curl init failed\n"); return FAILURE);
+          break;
+        }
+        next++;
+        if (!attempt && lookup(config, transfer, options)) {
+          idle.push_back(curl);
+          transfer.request->status = http::code::OK;
+          finished(*transfer.request);
+          continue;
+        }
+        if (redmine::result failed = submit(curl, transfer)) {
+          idle.push_back(curl);
+          transfer.request->error = failed;
+          finished(*transfer.request);
+          continue;
+        }
+        pending++;
+      }
+      return SUCCESS;
+    };
+
+    CHECK_RETURN(fill());
+    while (pending) {
+      int running = 0;
+      curl_multi_perform(multi, &running);
+
+      int queued = 0;
+      while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+        if (CURLMSG_DONE != message->msg) {
+          continue;
+        }
+        CURL *curl = message->easy_handle;
+        const CURLcode code = message->data.result;
+        transfer *done = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &done);
+        record(curl, "GET", done->path);
+        long status = 0;
+        if (CURLE_OK == code) {
+          curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        }
+        if (attempt < config.current->retries &&
+            transient(code, static_cast<http::status>(status))) {
+          CHECK(options.debug,
+                printf("retry %u/%u: %s: %s\n", attempt + 1,
+                       config.current->retries, done->path.c_str(),
+                       CURLE_OK == code ? std::to_string(status).c_str()
+                                        : curl_easy_strerror(code)));
+          retry.push_back(done);
+        } else {
+          finish_request(code, static_cast<http::status>(status), *done,
+                         config, options);
+          finished(*done->request);
+        }
+        curl_multi_remove_handle(multi, curl);
+        idle.push_back(curl);
+        pending--;
+      }
+
+      if (stop()) {
+        for (size_t index = 0; index < used; index++) {
+          CURL *curl = active->handles[index];
+          if (idle.end() == std::find(idle.begin(), idle.end(), curl)) {
+            curl_multi_remove_handle(multi, curl);
+          }
+        }
+        break;
+      }
+      CHECK_RETURN(fill());
+      if (pending) {
+        curl_multi_wait(multi, nullptr, 0, 1000, nullptr);
+      }
+    }
+    // NOTE: A window which does not grow once every admitted request has
+    // finished would leave the rest waiting forever, give up on them too.
+    stopped = stop() || next < queue.size();
+
+    if (!retry.empty() && !stopped) {
+      uint64_t delay = 0;
+      for (auto transfer : retry) {
+        delay = std::max(delay, retry_delay(config, attempt,
+                                            transfer->headers.retry_after));
+        transfer->reset();
+      }
+      CHECK(options.debug, printf("retry %zu requests in %llums\n",
+                                  retry.size(), (unsigned long long)delay));
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+    queue.swap(retry);
+  }
+
+  for (size_t index = 0; index < requests.size(); index++) {
+    if (!reported[index] && !requests[index].error) {
+      requests[index].error = FAILURE;
+    }
+  }
+  for (auto &request : requests) {
+    if (request.error) {
+      return request.error;
+    }
+  }
+
+  return SUCCESS;
+}
+
+result http::get(std::vector<http::request> &requests, const config &config,
+                 redmine::options &options,
+                 const std::function<void(http::request &)> &complete) {
+  return perform(requests, config, options, complete, nullptr, nullptr);
+}
+
+void http::prefetch(std::vector<http::request> requests, const config &config,
+                    redmine::options &options) {
+  http::get(requests, config, options);
+  if (!active) {
+    return;
+  }
+  for (auto &request : requests) {
+    if (!request.error) {
+      active->responses[request.path] = std::move(request.body);
+    }
+  }
+}
+
+std::string http::page(const std::string &path, const uint32_t offset,
+                       const uint32_t limit) {
+  return path + (std::string::npos == path.find('?') ? "?" : "&") +
+         "offset=" + std::to_string(offset) +
+         "&limit=" + std::to_string(limit);
+}
+
+/// @brief Request the first page of a paginated collection.
+///
+/// @param remaining Requests of the remaining pages, in order of offset.
+static result first_page(const std::string &path, const config &config,
+                         redmine::options &options, http::request &first,
+                         std::vector<http::request> &remaining,
+                         const http::caching caching) {
+  CHECK_RETURN(http::get(first.path, config, options, first.body, caching));
+  first.status = http::code::OK;
+
+  // NOTE: Only the counts at the top level are read, errors are left for the
+  // caller to report when it reads the page.
+  json::tape tape;
+  if (!json::read(first.body, tape, false)) {
+    return SUCCESS;
+  }
+  auto &Root = tape.root();
+  if (json::TYPE_OBJECT != Root.type()) {
+    return SUCCESS;
+  }
+  auto Limit = Root.get("limit");
+  auto TotalCount = Root.get("total_count");
+  if (!Limit || json::TYPE_NUMBER != Limit->type() || !TotalCount ||
+      json::TYPE_NUMBER != TotalCount->type()) {
+    return SUCCESS;
+  }
+  // NOTE: The server may cap the requested limit, page by the one it used.
+  const uint32_t limit = Limit->number<uint32_t>();
+  const uint32_t total_count = TotalCount->number<uint32_t>();
+  if (!limit || total_count <= limit) {
+    return SUCCESS;
+  }
+
+  remaining.reserve((total_count - 1) / limit);
+  for (uint32_t offset = limit; offset < total_count; offset += limit) {
+    remaining.emplace_back(http::page(path, offset, limit), caching);
+  }
+  CHECK(options.debug, printf("%zu more pages of %u entries\n",
+                              remaining.size(), limit));
+  return SUCCESS;
+}
+
+result http::get_pages(const std::string &path, const config &config,
+                       redmine::options &options,
+                       std::vector<http::request> &pages,
+                       const http::caching caching) {
+  pages.clear();
+  pages.emplace_back(http::page(path), caching);
+  std::vector<http::request> remaining;
+  CHECK_RETURN(
+      first_page(path, config, options, pages.front(), remaining, caching));
+  CHECK_RETURN(get(remaining, config, options));
+  for (auto &request : remaining) {
+    pages.push_back(std::move(request));
+  }
+  return SUCCESS;
+}
+
+result http::get_pages(const std::string &path, const config &config,
+                       redmine::options &options, std::deque<json::tape> &pages,
+                       const http::caching caching) {
+  std::vector<http::request> requests;
+  CHECK_RETURN(get_pages(path, config, options, requests, caching));
+  timings::scope timing("json::tape");
+  pages.clear();
+  for (auto &request : requests) {
+    pages.emplace_back();
+    CHECK(!json::read(std::move(request.body), pages.back(), options.debug),
+          return FAILURE);
+  }
+  return SUCCESS;
+}
+
+result http::get_pages(const std::string &path, const config &config,
+                       redmine::options &options,
+                       const std::function<result(http::request &page)> &read,
+                       const http::caching caching) {
+  http::request first(http::page(path), caching);
+  std::vector<http::request> remaining;
+  CHECK_RETURN(first_page(path, config, options, first, remaining, caching));
+  CHECK_RETURN(read(first));
+
+  // NOTE: Pages complete in any order, read each once all those before it
+  // have been read. Pages are only requested up to the concurrency limit past
+  // the next one to read so at most that many are held at once, and no more
+  // are requested once reading fails.
+  std::vector<bool> completed(remaining.size(), false);
+  size_t next = 0;
+  result error = SUCCESS;
+  auto complete = [&](http::request &request) {
+    completed[&request - remaining.data()] = true;
+    while (!error && next < remaining.size() && completed[next]) {
+      http::request &page = remaining[next++];
+      error = page.error ? page.error : read(page);
+      std::string().swap(page.body);
+    }
+  };
+  const size_t window = std::max<uint32_t>(config.current->concurrency, 1);
+  result failed = perform(remaining, config, options, complete,
+                          [&] { return next + window; },
+                          [&] { return SUCCESS != error; });
+  return error ? error : failed;
+}
+
 result http::post(const std::string &path, const config &config,
                   redmine::options &options, const http::status expected,
                   const std::string &str, std::string &body) {
   CHECK(options.debug, printf("%s\n", path.c_str()));
-  curl_raii curl;
-  CHECK(!curl.valid(), fprintf(stderr, "curl init failed\n"); return FAILURE);
+  CHECK_RETURN(prepare_session(config));
+  CURL *curl = active->handle;
   CHECK_RETURN(set_options(curl, path, config, options));
   CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_POSTFIELDS, str.c_str()));
   CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write));
   CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body));
 
   CURL_CHECK_RETURN(curl_easy_perform(curl));
-  status status;
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+  record(curl, "POST", path);
+  long code = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+  http::status status = static_cast<http::status>(code);
 
   CHECK(options.debug, printf("body: %s\n", body.c_str()));
   CHECK(expected != status, print_http_error(status); return FAILURE);
@@ -161,17 +1000,24 @@ result http::post(const std::string &path, const config &config,
 result http::put(const std::string &path, const redmine::config &config,
                  redmine::options &options, const http::status expected,
                  const std::string &data) {
-  curl_raii curl;
-  CHECK(!curl.valid(), fprintf(stderr, "curl init failed\n"); return FAILURE);
-  CHECK_RETURN(set_options(curl, path, config, options));
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_PUT, true));
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_READFUNCTION, read));
+  CHECK_RETURN(prepare_session(config));
   read_state state(data);
-  CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_READDATA, &state));
-
-  CURL_CHECK_RETURN(curl_easy_perform(curl));
+  response_headers headers;
   http::status status;
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+  auto setup = [&](CURL *curl) -> result {
+    state.index = 0;
+    CHECK_RETURN(set_options(curl, path, config, options));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                                       static_cast<curl_off_t>(data.size())));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_READFUNCTION, read));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_READDATA, &state));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header));
+    CURL_CHECK_RETURN(curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers));
+    return SUCCESS;
+  };
+  CHECK_RETURN(
+      perform("PUT", path, config, options, headers, status, setup));
 
   CHECK(expected != status, print_http_error(status); return FAILURE);
 
@@ -243,7 +1089,10 @@ result print_curl_error(CURLcode error, const char *file, const int line) {
     CASE(CURLE_OBSOLETE57)
     CASE(CURLE_SSL_CERTPROBLEM)
     CASE(CURLE_SSL_CIPHER)
+#if LIBCURL_VERSION_NUM < 0x073e00
+    // NOTE: Since curl 7.62.0 this aliases CURLE_PEER_FAILED_VERIFICATION
     CASE(CURLE_SSL_CACERT)
+#endif
     CASE(CURLE_BAD_CONTENT_ENCODING)
     CASE(CURLE_LDAP_INVALID_URL)
     CASE(CURLE_FILESIZE_EXCEEDED)
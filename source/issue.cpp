@@ -18,12 +18,14 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <bind.h>
 #include <enumeration.h>
 #include <http.h>
 #include <issue.h>
 #include <project.h>
 #include <membership.h>
 #include <role.h>
+#include <timings.h>
 #include <tracker.h>
 #include <util.h>
 #include <version.h>
@@ -72,94 +74,64 @@ static std::string &rtrim(std::string &str) {
 
 static std::string &trim(std::string &str) { return ltrim(rtrim(str)); }
 
-redmine::result redmine::issue::init(const json::object &object) {
-  auto Id = object.get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
-
-  auto Subject = object.get("subject");
-  CHECK_JSON_PTR(Subject, json::TYPE_STRING);
-  subject = Subject->string();
-
-  auto Description = object.get("description");
-  CHECK_JSON_PTR(Description, json::TYPE_STRING);
-  description = Description->string();
-
-  auto StartDate = object.get("start_date");
-  CHECK_JSON_PTR(StartDate, json::TYPE_STRING);
-  start_date = StartDate->string();
-
-  auto DueDate = object.get("due_date");
-  if (DueDate) {
-    CHECK_JSON_TYPE(*DueDate, json::TYPE_STRING);
-    due_date = DueDate->string();
-  }
-
-  auto CreatedOn = object.get("created_on");
-  CHECK_JSON_PTR(CreatedOn, json::TYPE_STRING);
-  created_on = CreatedOn->string();
-
-  auto UpdatedOn = object.get("updated_on");
-  CHECK_JSON_PTR(UpdatedOn, json::TYPE_STRING);
-  updated_on = UpdatedOn->string();
-
-  auto DoneRatio = object.get("done_ratio");
-  CHECK_JSON_PTR(DoneRatio, json::TYPE_NUMBER);
-  done_ratio = DoneRatio->number<uint32_t>();
-
-  auto EstimatedHours = object.get("estimated_hours");
-  if (EstimatedHours) {
-    CHECK_JSON_TYPE(*EstimatedHours, json::TYPE_NUMBER);
-    estimated_hours = EstimatedHours->number<uint32_t>();
-  }
-
-  auto getRef = [](const json::object &object, reference &reference) -> result {
-    auto name = object.get("name");
-    CHECK_JSON_PTR(name, json::TYPE_STRING);
-    reference.name = name->string();
-
-    auto id = object.get("id");
-    CHECK_JSON_PTR(id, json::TYPE_NUMBER);
-    reference.id = id->number<uint32_t>();
+template <typename Object>
+redmine::result redmine::issue::init(const Object &object) {
+  timings::scope timing("issue::init");
+  return bind::read(object, *this);
+}
 
-    return SUCCESS;
+template redmine::result redmine::issue::init(const json::object &object);
+template redmine::result redmine::issue::init(const json::node &object);
+
+const std::vector<redmine::bind::field<redmine::issue>>
+    &redmine::issue::fields() {
+  static const std::vector<bind::field<issue>> fields = {
+      BIND_FIELD(issue, id, REQUIRED),
+      BIND_FIELD(issue, project, REQUIRED),
+      BIND_FIELD(issue, tracker, REQUIRED),
+      BIND_FIELD(issue, status, REQUIRED),
+      BIND_FIELD(issue, priority, REQUIRED),
+      BIND_FIELD(issue, author, REQUIRED),
+      BIND_FIELD(issue, assigned_to, OPTIONAL),
+      BIND_FIELD(issue, category, OPTIONAL),
+      BIND_FIELD(issue, subject, REQUIRED),
+      BIND_FIELD(issue, description, REQUIRED),
+      BIND_FIELD(issue, start_date, REQUIRED),
+      BIND_FIELD(issue, due_date, OPTIONAL),
+      BIND_FIELD(issue, done_ratio, REQUIRED),
+      BIND_FIELD(issue, estimated_hours, OPTIONAL),
+      BIND_FIELD(issue, created_on, REQUIRED),
+      BIND_FIELD(issue, updated_on, REQUIRED),
+      BIND_FIELD(issue, journals, OPTIONAL),
   };
+  return fields;
+}
 
-  auto Project = object.get("project");
-  CHECK_JSON_PTR(Project, json::TYPE_OBJECT);
-  CHECK_RETURN(getRef(Project->object(), project));
-
-  auto Tracker = object.get("tracker");
-  CHECK_JSON_PTR(Tracker, json::TYPE_OBJECT);
-  CHECK_RETURN(getRef(Tracker->object(), tracker));
-
-  auto Status = object.get("status");
-  CHECK_JSON_PTR(Status, json::TYPE_OBJECT);
-  CHECK_RETURN(getRef(Status->object(), status));
-
-  auto Priority = object.get("priority");
-  CHECK_JSON_PTR(Priority, json::TYPE_OBJECT);
-  CHECK_RETURN(getRef(Priority->object(), priority));
-
-  auto Author = object.get("author");
-  CHECK_JSON_PTR(Author, json::TYPE_OBJECT);
-  CHECK_RETURN(getRef(Author->object(), author));
-
-  auto AssignedTo = object.get("assigned_to");
-  if (AssignedTo) {
-    CHECK_JSON_TYPE((*AssignedTo), json::TYPE_OBJECT);
-    CHECK_RETURN(getRef(AssignedTo->object(), assigned_to));
-  }
-
-  auto Category = object.get("category");
-  if (Category) {
-    CHECK_JSON_TYPE(*Category, json::TYPE_OBJECT);
-    CHECK_RETURN(getRef(Category->object(), category));
-  }
+const std::vector<redmine::bind::field<redmine::issue::journal>>
+    &redmine::issue::journal::fields() {
+  static const std::vector<bind::field<journal>> fields = {
+      BIND_FIELD(journal, id, REQUIRED),
+      BIND_FIELD(journal, user, REQUIRED),
+      BIND_FIELD(journal, notes, OPTIONAL),
+      BIND_FIELD(journal, created_on, REQUIRED),
+      BIND_FIELD(journal, details, OPTIONAL),
+  };
+  return fields;
+}
 
-  return SUCCESS;
+const std::vector<redmine::bind::field<redmine::issue::journal::detail>>
+    &redmine::issue::journal::detail::fields() {
+  static const std::vector<bind::field<detail>> fields = {
+      BIND_FIELD(detail, property, REQUIRED),
+      BIND_FIELD(detail, name, REQUIRED),
+      BIND_FIELD(detail, old_value, OPTIONAL),
+      BIND_FIELD(detail, new_value, OPTIONAL),
+  };
+  return fields;
 }
 
+json::object redmine::issue::jsonify() const { return bind::write(*this); }
+
 redmine::result redmine::issue::get(const uint32_t ID,
                                     const redmine::config &config,
                                     redmine::options &options) {
@@ -169,14 +141,13 @@ redmine::result redmine::issue::get(const uint32_t ID,
 redmine::result redmine::issue::get(const std::string &ID,
                                     const redmine::config &config,
                                     redmine::options &options) {
-  std::string body;
+  json::tape Tape;
   CHECK_RETURN(http::get("/issues/" + ID + ".json?include=journals", config,
-                         options, body));
-
-  json::value Root = json::read(body, false);
+                         options, Tape));
+  auto &Root = Tape.root();
   CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
 
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+  CHECK(options.debug, json::write(Root.value(), stdout, "  "); printf("\n"));
 
   auto Issue = Root.object().get("issue");
   CHECK_JSON_PTR(Issue, json::TYPE_OBJECT);
@@ -255,16 +226,16 @@ redmine::result redmine::action::issue_list(redmine::cl::args &args,
 
   // TODO: Support listing other users issues
 
-  std::vector<redmine::issue> issues;
-  CHECK_RETURN(query::issues(filter, config, options, issues));
-
   printf(
       "    id | subject\n"
       "-------|----------------------------------------------------------------"
       "-------\n");
-  for (auto &issue : issues) {
-    printf("%6d | %s\n", issue.id, issue.subject.c_str());
-  }
+  CHECK_RETURN(query::issues(filter, config, options,
+                             [](redmine::issue &issue) {
+                               printf("%6d | %s\n", issue.id,
+                                      issue.subject.c_str());
+                               return SUCCESS;
+                             }));
 
   return SUCCESS;
 }
@@ -339,6 +310,15 @@ redmine::result redmine::action::issue_new(redmine::cl::args &args,
   CHECK_MSG(0 == args.count(), "missing project id or identifier",
             return FAILURE);
 
+  // NOTE: Fetch the project list and the global metadata concurrently, the
+  // queries below are then served by the session without a round-trip each.
+  http::prefetch(
+      {{http::page("/projects.json"), http::CACHED},
+       {http::page("/trackers.json"), http::CACHED},
+       {http::page("/issue_statuses.json"), http::CACHED},
+       {"/enumerations/issue_priorities.json", http::CACHED}},
+      config, options);
+
   std::vector<redmine::project> projects;
   CHECK_RETURN(query::projects(config, options, projects));
 
@@ -363,6 +343,16 @@ redmine::result redmine::action::issue_new(redmine::cl::args &args,
     subject = args[2];
   }
 
+  const std::string prefix = "/projects/" + project->identifier;
+  std::vector<http::request> requests{
+      {http::page(prefix + "/versions.json"), http::CACHED},
+      {http::page(prefix + "/memberships.json")}};
+  if (user.can(redmine::MANAGE_CATEGORIES)) {
+    requests.push_back(
+        {http::page(prefix + "/issue_categories.json"), http::CACHED});
+  }
+  http::prefetch(requests, config, options);
+
   std::vector<redmine::reference> trackers;
   CHECK_RETURN(query::trackers(config, options, trackers));
 
@@ -373,7 +363,7 @@ redmine::result redmine::action::issue_new(redmine::cl::args &args,
   CHECK_RETURN(query::issue_priorities(config, options, priorities));
 
   std::vector<redmine::issue_category> issue_categories;
-  if (user.permissions.manage_categories) {
+  if (user.can(redmine::MANAGE_CATEGORIES)) {
     CHECK_RETURN(query::issue_categories(project->identifier, config, options,
                                          issue_categories));
   }
@@ -489,14 +479,15 @@ redmine::result redmine::action::issue_new(redmine::cl::args &args,
   issue.add("custom_fields", json::value());
 #endif
   if (watcher_user_ids.size()) {
-    issue.add("watcher_user_ids", watcher_user_ids);
+    issue.add("watcher_user_ids", std::move(watcher_user_ids));
   }
 #if 0
   issue.add("is_private", is_private);
   issue.add("estimated_hours", estimated_hours);
 #endif
 
-  std::string data = json::write(json::object{"issue", issue}, "  ");
+  std::string data =
+      json::write(json::object{"issue", std::move(issue)}, json::compact);
 
   CHECK(options.debug, printf("%s\n", data.c_str()));
 
@@ -504,9 +495,10 @@ redmine::result redmine::action::issue_new(redmine::cl::args &args,
   CHECK_RETURN(http::post("/issues.json", config, options, http::code::CREATED,
                           data, body))
 
-  auto ResponseRoot = json::read(body, false);
+  auto ResponseRoot =
+      timings::time("json::read", [&] { return json::read(body, false); });
   CHECK_JSON_TYPE(ResponseRoot, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(ResponseRoot, "  ").c_str()));
+  CHECK(options.debug, json::write(ResponseRoot, stdout, "  "); printf("\n"));
 
   // NOTE: Display new issue id and path to website.
   auto Issue = ResponseRoot.object().get("issue");
@@ -608,6 +600,10 @@ redmine::result redmine::action::issue_update(redmine::cl::args &args,
 
   // NOTE: Get the issue and check its valid.
   std::string id(args[0]);
+  http::prefetch(
+      {{"/issues/" + id + ".json?include=journals"},
+       {http::page("/issue_statuses.json"), http::CACHED}},
+      config, options);
   redmine::issue issue;
   CHECK_RETURN(issue.get(id, config, options));
 
@@ -683,7 +679,8 @@ redmine::result redmine::action::issue_update(redmine::cl::args &args,
     Issue.add("assigned_to_id", assigned_to_id);
   }
 
-  std::string json = json::write(json::object("issue", Issue), "  ");
+  std::string json =
+      json::write(json::object("issue", std::move(Issue)), json::compact);
   CHECK(options.debug, printf("%s\n", json.c_str()));
 
   CHECK_RETURN(http::put("/issues/" + id + ".json", config, options,
@@ -700,68 +697,81 @@ redmine::result redmine::action::issue_update(redmine::cl::args &args,
 redmine::result redmine::query::issues(std::string &filter, config &config,
                                        redmine::options &options,
                                        std::vector<issue> &issues) {
-  std::string body;
-  CHECK_RETURN(http::get("/issues.json" + filter, config, options, body));
-
-  auto Root = json::read(body, true);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+  return query::issues(filter, config, options, [&](redmine::issue &issue) {
+    issues.push_back(std::move(issue));
+    return SUCCESS;
+  });
+}
 
-  auto Issues = Root.object().get("issues");
-  CHECK_JSON_PTR(Issues, json::TYPE_ARRAY);
+redmine::result redmine::query::issues(
+    const std::string &filter, config &config, redmine::options &options,
+    const std::function<result(redmine::issue &issue)> &row) {
+  auto read = [&](http::request &Page) -> result {
+    json::tape Tape;
+    CHECK(!json::read(std::move(Page.body), Tape, options.debug),
+          return FAILURE);
+    auto &Root = Tape.root();
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
 
-  for (auto Issue : Issues->array()) {
-    CHECK_JSON_TYPE(Issue, json::TYPE_OBJECT);
+    CHECK(options.debug,
+          json::write(Root.value(), stdout, "  "); printf("\n"));
 
-    redmine::issue issue;
-    CHECK_RETURN(issue.init(Issue.object()));
+    auto Issues = Root.object().get("issues");
+    CHECK_JSON_PTR(Issues, json::TYPE_ARRAY);
 
-    issues.push_back(issue);
-  }
+    for (auto &Issue : Issues->array()) {
+      CHECK_JSON_TYPE(Issue, json::TYPE_OBJECT);
 
-  return SUCCESS;
+      redmine::issue issue;
+      CHECK_RETURN(issue.init(Issue.object()));
+      CHECK_RETURN(row(issue));
+    }
+    return SUCCESS;
+  };
+  return http::get_pages("/issues.json" + filter, config, options, read);
 }
 
 redmine::result redmine::query::issue_statuses(
     redmine::config &config, redmine::options &options,
     std::vector<issue_status> &statuses) {
-  std::string body;
-  CHECK_RETURN(http::get("/issue_statuses.json?offset=0&limit=1000000", config,
-                         options, body));
-
-  auto root = json::read(body, false);
-  CHECK_JSON_TYPE(root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(root, "  ").c_str()));
-
-  auto Statuses = root.object().get("issue_statuses");
-  CHECK_JSON_PTR(Statuses, json::TYPE_ARRAY);
-
-  for (auto &Status : Statuses->array()) {
-    CHECK_JSON_TYPE(Status, json::TYPE_OBJECT);
-    issue_status status;
-
-    auto name = Status.object().get("name");
-    CHECK_JSON_PTR(name, json::TYPE_STRING);
-    status.name = name->string();
-
-    auto id = Status.object().get("id");
-    CHECK_JSON_PTR(id, json::TYPE_NUMBER);
-    status.id = id->number<uint32_t>();
+  std::deque<json::tape> Pages;
+  CHECK_RETURN(http::get_pages("/issue_statuses.json", config, options, Pages,
+                               http::CACHED));
+  for (auto &Page : Pages) {
+    auto &root = Page.root();
+    CHECK_JSON_TYPE(root, json::TYPE_OBJECT);
+    CHECK(options.debug,
+          json::write(root.value(), stdout, "  "); printf("\n"));
+
+    auto Statuses = root.object().get("issue_statuses");
+    CHECK_JSON_PTR(Statuses, json::TYPE_ARRAY);
+
+    for (auto &Status : Statuses->array()) {
+      CHECK_JSON_TYPE(Status, json::TYPE_OBJECT);
+      issue_status status;
+
+      auto name = Status.object().get("name");
+      CHECK_JSON_PTR(name, json::TYPE_STRING);
+      status.name = name->string();
+
+      auto id = Status.object().get("id");
+      CHECK_JSON_PTR(id, json::TYPE_NUMBER);
+      status.id = id->number<uint32_t>();
+
+      auto is_default = Status.object().get("is_default");
+      if (is_default) {
+        CHECK_JSON_TYPE(*is_default, json::TYPE_BOOL);
+        status.is_default = is_default->boolean();
+      }
 
-    auto is_default = Status.object().get("is_default");
-    if (is_default) {
-      CHECK_JSON_TYPE(*is_default, json::TYPE_BOOL);
-      status.is_default = is_default->boolean();
-    }
+      auto is_closed = Status.object().get("is_closed");
+      if (is_closed) {
+        CHECK_JSON_TYPE(*is_closed, json::TYPE_BOOL);
+        status.is_closed = is_closed->boolean();
+      }
 
-    auto is_closed = Status.object().get("is_closed");
-    if (is_closed) {
-      CHECK_JSON_TYPE(*is_closed, json::TYPE_BOOL);
-      status.is_closed = is_closed->boolean();
+      statuses.push_back(status);
     }
-
-    statuses.push_back(status);
   }
 
   return SUCCESS;
@@ -770,42 +780,44 @@ redmine::result redmine::query::issue_statuses(
 redmine::result redmine::query::issue_categories(
     const std::string &project, redmine::config &config,
     redmine::options &options, std::vector<issue_category> &issue_categories) {
-  std::string body;
-  CHECK_RETURN(http::get(
-      "/projects/" + project + "/issue_categories.json?offset=0&limit=1000000",
-      config, options, body));
-
-  auto Root = json::read(body, false);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
-
-  auto IssueCategories = Root.object().get("issue_categories");
-  CHECK_JSON_PTR(IssueCategories, json::TYPE_ARRAY);
-
-  for (auto &IssueCategory : IssueCategories->array()) {
-    CHECK_JSON_TYPE(IssueCategory, json::TYPE_OBJECT);
-
-    redmine::issue_category issue_category;
-
-    auto Id = IssueCategory.object().get("id");
-    CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-    issue_category.id = Id->number<uint32_t>();
-
-    auto Name = IssueCategory.object().get("name");
-    CHECK_JSON_PTR(Name, json::TYPE_STRING);
-    issue_category.name = Name->string();
-
-    auto Project = IssueCategory.object().get("project");
-    CHECK_JSON_PTR(Project, json::TYPE_OBJECT);
-    CHECK_RETURN(issue_category.project.init(Project->object()));
+  std::deque<json::tape> Pages;
+  CHECK_RETURN(
+      http::get_pages("/projects/" + project + "/issue_categories.json",
+                      config, options, Pages, http::CACHED));
+  for (auto &Page : Pages) {
+    auto &Root = Page.root();
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+    CHECK(options.debug,
+          json::write(Root.value(), stdout, "  "); printf("\n"));
+
+    auto IssueCategories = Root.object().get("issue_categories");
+    CHECK_JSON_PTR(IssueCategories, json::TYPE_ARRAY);
+
+    for (auto &IssueCategory : IssueCategories->array()) {
+      CHECK_JSON_TYPE(IssueCategory, json::TYPE_OBJECT);
+
+      redmine::issue_category issue_category;
+
+      auto Id = IssueCategory.object().get("id");
+      CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
+      issue_category.id = Id->number<uint32_t>();
+
+      auto Name = IssueCategory.object().get("name");
+      CHECK_JSON_PTR(Name, json::TYPE_STRING);
+      issue_category.name = Name->string();
+
+      auto Project = IssueCategory.object().get("project");
+      CHECK_JSON_PTR(Project, json::TYPE_OBJECT);
+      CHECK_RETURN(issue_category.project.init(Project->object()));
+
+      auto AssignedTo = IssueCategory.object().get("assigned_to");
+      if (AssignedTo) {
+        CHECK_JSON_TYPE(*AssignedTo, json::TYPE_OBJECT);
+        CHECK_RETURN(issue_category.assigned_to.init(AssignedTo->object()));
+      }
 
-    auto AssignedTo = IssueCategory.object().get("assigned_to");
-    if (AssignedTo) {
-      CHECK_JSON_TYPE(*AssignedTo, json::TYPE_OBJECT);
-      CHECK_RETURN(issue_category.assigned_to.init(AssignedTo->object()));
+      issue_categories.push_back(issue_category);
     }
-
-    issue_categories.push_back(issue_category);
   }
 
   return SUCCESS;
@@ -0,0 +1,232 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <command_line.h>
+#include <redmine.h>
+#include <config.h>
+#include <issue.h>
+#include <http.h>
+#include <project.h>
+#include <timings.h>
+#include <user.h>
+
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/// @brief What an action needs to know about the current user before it runs.
+enum requirement {
+  /// @brief Nothing, no requests are made.
+  REQUIRE_NOTHING,
+  /// @brief The user and their memberships, a single request.
+  REQUIRE_USER,
+  /// @brief The permissions of the roles of each membership as well.
+  REQUIRE_PERMISSIONS,
+};
+
+/// @brief What an action needs from the current user and which of their
+/// permissions it checks, only those permissions are resolved.
+struct action_permissions {
+  /// @brief Name of the action, null when help is shown.
+  const char *action;
+  /// @brief Name of the subaction, null matches any or none.
+  const char *subaction;
+  requirement required;
+  /// @brief Permissions the action checks.
+  std::vector<redmine::permisson> checked;
+  /// @brief The action may be used if any of these is granted, it may always
+  /// be used when there are none. Help lists issue when they are granted.
+  std::vector<redmine::permisson> allowed;
+};
+
+/// @brief Declare the requirements of each action, the first match is used.
+///
+/// Help lists the issue action only for users allowed to use it and the user
+/// action only for users whose status is visible. Issue is allowed with any
+/// permission on issues.
+///
+/// @param action Name of the action, null when help is shown.
+/// @param subaction Name of the subaction, null if there is none.
+static const action_permissions &find_action(const char *action,
+                                             const char *subaction) {
+  static const std::vector<redmine::permisson> issue = {
+      redmine::ADD_ISSUES, redmine::VIEW_ISSUES, redmine::EDIT_ISSUES,
+      redmine::ADD_ISSUE_NOTES, redmine::ADD_ISSUE_WATCHERS};
+  static const action_permissions actions[] = {
+      {nullptr, nullptr, REQUIRE_PERMISSIONS, issue, issue},
+      {"issue",
+       "new",
+       REQUIRE_PERMISSIONS,
+       {redmine::ADD_ISSUES, redmine::VIEW_ISSUES, redmine::EDIT_ISSUES,
+        redmine::ADD_ISSUE_NOTES, redmine::ADD_ISSUE_WATCHERS,
+        redmine::MANAGE_CATEGORIES},
+       issue},
+      {"issue", nullptr, REQUIRE_PERMISSIONS, issue, issue},
+      {"user", nullptr, REQUIRE_USER, {}, {}},
+  };
+  static const action_permissions anything = {
+      nullptr, nullptr, REQUIRE_NOTHING, {}, {}};
+  for (auto &entry : actions) {
+    const bool match =
+        action && entry.action
+            ? !strcmp(entry.action, action) &&
+                  (!entry.subaction ||
+                   (subaction && !strcmp(entry.subaction, subaction)))
+            : action == entry.action;
+    if (match) {
+      return entry;
+    }
+  }
+  return anything;
+}
+
+/// @brief Print the recorded timings when main returns, failed requests are
+/// the ones most worth timing so this includes returning an error.
+struct timings_report {
+  timings_report(const redmine::options &options) : options(options) {}
+
+  ~timings_report() {
+    if (options.timings) {
+      redmine::timings::print();
+    }
+  }
+
+  const redmine::options &options;
+};
+
+int main(int argc, char **argv) {
+  redmine::cl::args args(argc, argv);
+  args++;
+
+  redmine::options options;
+  int index = 0;
+  for (; index < args.count(); ++index) {
+    const char *arg = args[index];
+
+    if (!strcmp("-h", arg) || !strcmp("--help", arg)) {
+      options.help = true;
+      break;
+    }
+
+    if (!strcmp("--verbose", arg)) {
+      options.verbose = true;
+      CHECK(args.end() - 1 == &arg, fprintf(stderr, "action required\n");
+            return redmine::ACTION_REQUIRED);
+      continue;
+    }
+
+    if (!strcmp("--debug", arg)) {
+      options.debug = true;
+      CHECK(args.end() - 1 == &arg, fprintf(stderr, "action required\n");
+            return redmine::ACTION_REQUIRED);
+      continue;
+    }
+
+    if (!strcmp("--debug-http", arg)) {
+      options.debug_http = true;
+      CHECK(args.end() - 1 == &arg, fprintf(stderr, "action required\n");
+            return redmine::ACTION_REQUIRED);
+      continue;
+    }
+
+    if (!strcmp("--timings", arg)) {
+      options.timings = true;
+      redmine::timings::enable();
+      CHECK(args.end() - 1 == &arg, fprintf(stderr, "action required\n");
+            return redmine::ACTION_REQUIRED);
+      continue;
+    }
+
+    break;
+  }
+  args += index;
+
+  timings_report report(options);
+  redmine::http::session http;
+  CHECK_RETURN(http.init());
+
+  redmine::config config;
+  if (config.load(options)) {
+    CHECK_RETURN(redmine::config_interactive(options));
+    CHECK_RETURN(config.load(options));
+  }
+
+  const bool help = options.help || 0 == args.count();
+  const action_permissions &action =
+      find_action(help ? nullptr : args[0],
+                  help || 1 == args.count() ? nullptr : args[1]);
+  redmine::current_user user;
+  if (REQUIRE_USER <= action.required) {
+    CHECK_RETURN(user.get(config, options));
+  }
+  if (REQUIRE_PERMISSIONS <= action.required) {
+    std::bitset<redmine::PERMISSION_COUNT> checked;
+    for (auto permission : action.checked) {
+      checked.set(permission);
+    }
+    CHECK_RETURN(user.resolve(config, options, checked));
+  }
+
+  bool allowed = action.allowed.empty();
+  for (auto permission : action.allowed) {
+    allowed = allowed || user.can(permission);
+  }
+  const bool use_user = 0 != user.status;
+
+  if (help) {
+    printf(
+        "usage: redmine [options] <action> [args]\n"
+        "actions:\n");
+    printf("        config\n");
+    printf("        project\n");
+    if (allowed) {
+      printf("        issue\n");
+    }
+    if (use_user) {
+      printf("        user\n");
+    }
+    printf(
+        "options:\n"
+        "        --verbose - verbose output\n"
+        "        --debug - enable debug output\n"
+        "        --debug-http - enable http debug output\n"
+        "        --timings - print request and parse timings\n");
+
+    return redmine::SUCCESS;
+  }
+
+  const char *arg = args[0];
+  args++;
+  redmine::result result = redmine::FAILURE;
+  if (!strcmp("config", arg)) {
+    result = redmine::action::config(args, options);
+  } else if (!strcmp("project", arg)) {
+    result = redmine::action::project(args, config, options);
+  } else if (allowed && !strcmp("issue", arg)) {
+    result = redmine::action::issue(args, config, user, options);
+  } else if (use_user && !strcmp("user", arg)) {
+    result = redmine::action::user(args, config, options);
+  } else {
+    fprintf(stderr, "invalid action: %s\n", arg);
+  }
+
+  return result;
+}
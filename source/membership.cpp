@@ -18,68 +18,57 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <bind.h>
 #include <http.h>
 #include <membership.h>
+#include <timings.h>
 
 redmine::membership::membership() : id(), project(), user(), roles() {}
 
-redmine::result redmine::membership::init(const json::object &object) {
-  auto Id = object.get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
-
-  auto Project = object.get("project");
-  CHECK_JSON_PTR(Project, json::TYPE_OBJECT);
-  CHECK_RETURN(project.init(Project->object()));
-
-  auto User = object.get("user");
-  CHECK_JSON_PTR(User, json::TYPE_OBJECT);
-  CHECK_RETURN(user.init(User->object()));
-
-  auto Roles = object.get("roles");
-  CHECK_JSON_PTR(Roles, json::TYPE_ARRAY);
-  for (auto &Role : Roles->array()) {
-    CHECK_JSON_TYPE(Role, json::TYPE_OBJECT);
-
-    reference role;
-    CHECK_RETURN(role.init(Role.object()));
-
-    roles.push_back(role);
-  }
+template <typename Object>
+redmine::result redmine::membership::init(const Object &object) {
+  timings::scope timing("membership::init");
+  return bind::read(object, *this);
+}
 
-  return SUCCESS;
+template redmine::result redmine::membership::init(
+    const json::object &object);
+template redmine::result redmine::membership::init(const json::node &object);
+
+const std::vector<redmine::bind::field<redmine::membership>>
+    &redmine::membership::fields() {
+  static const std::vector<bind::field<membership>> fields = {
+      BIND_FIELD(membership, id, REQUIRED),
+      BIND_FIELD(membership, project, REQUIRED),
+      BIND_FIELD(membership, user, REQUIRED),
+      BIND_FIELD(membership, roles, REQUIRED),
+  };
+  return fields;
 }
 
 redmine::result redmine::query::memberships(
     const std::string &project, config &config, redmine::options &options,
     std::vector<membership> &memberships) {
-  std::string body;
-  CHECK_RETURN(http::get(
-      "/projects/" + project + "/memberships.json?offset=0&limit=1000000",
-      config, options, body));
-
-  auto Root = json::read(body, false);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
-
-  auto Limit = Root.object().get("limit");
-  CHECK_JSON_PTR(Limit, json::TYPE_NUMBER);
-  uint32_t limit = Limit->number<uint32_t>();
-
-  auto TotalCount = Root.object().get("total_count");
-  CHECK_JSON_PTR(TotalCount, json::TYPE_NUMBER);
-  uint32_t total_count = TotalCount->number<uint32_t>();
-
-  json::value *Memberships = Root.object().get("memberships");
-  CHECK_JSON_PTR(Memberships, json::TYPE_ARRAY);
-
-  for (auto &Membership : Memberships->array()) {
-    CHECK_JSON_TYPE(Membership, json::TYPE_OBJECT);
-
-    redmine::membership membership;
-    CHECK_RETURN(membership.init(Membership.object()));
-
-    memberships.push_back(membership);
+  std::deque<json::tape> Pages;
+  CHECK_RETURN(http::get_pages("/projects/" + project + "/memberships.json",
+                               config, options, Pages));
+  for (auto &Page : Pages) {
+    auto &Root = Page.root();
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+    CHECK(options.debug,
+          json::write(Root.value(), stdout, "  "); printf("\n"));
+
+    auto Memberships = Root.object().get("memberships");
+    CHECK_JSON_PTR(Memberships, json::TYPE_ARRAY);
+
+    for (auto &Membership : Memberships->array()) {
+      CHECK_JSON_TYPE(Membership, json::TYPE_OBJECT);
+
+      redmine::membership membership;
+      CHECK_RETURN(membership.init(Membership.object()));
+
+      memberships.push_back(membership);
+    }
   }
 
   return SUCCESS;
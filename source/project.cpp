@@ -18,9 +18,11 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <bind.h>
 #include <config.h>
 #include <http.h>
 #include <project.h>
+#include <timings.h>
 #include <util.h>
 
 #include <json/json.hpp>
@@ -42,52 +44,31 @@ project::project()
       updated_on(),
       parent() {}
 
-result project::init(const json::object &object) {
-  auto Name = object.get("name");
-  CHECK_JSON_PTR(Name, json::TYPE_STRING);
-  name = Name->string();
-
-  auto Id = object.get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
-
-  auto Identifier = object.get("identifier");
-  CHECK_JSON_PTR(Identifier, json::TYPE_STRING);
-  identifier = Identifier->string();
-
-  auto Description = object.get("description");
-  CHECK_JSON_PTR(Description, json::TYPE_STRING);
-  description = Description->string();
-
-  auto CreatedOn = object.get("created_on");
-  CHECK_JSON_PTR(CreatedOn, json::TYPE_STRING);
-  created_on = CreatedOn->string();
-
-  auto UpdatedOn = object.get("updated_on");
-  CHECK_JSON_PTR(UpdatedOn, json::TYPE_STRING);
-  updated_on = UpdatedOn->string();
-
-  auto Parent = object.get("parent");
-  if (Parent) {
-    CHECK_JSON_TYPE(*Parent, json::TYPE_OBJECT);
-
-    auto Name = Parent->object().get("name");
-    CHECK_JSON_PTR(Name, json::TYPE_STRING);
-    parent.name = Name->string();
-
-    auto Id = Parent->object().get("id");
-    CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-    parent.id = Id->number<uint32_t>();
-  }
-
-  return SUCCESS;
+template <typename Object>
+result project::init(const Object &object) {
+  timings::scope timing("project::init");
+  return bind::read(object, *this);
 }
 
-json::object project::jsonify() const {
-  UNREACHABLE("redmine::project::jsonify() not implemented!");
-  return json::object();
+template result project::init(const json::object &object);
+template result project::init(const json::node &object);
+
+const std::vector<bind::field<project>> &project::fields() {
+  static const std::vector<bind::field<project>> fields = {
+      BIND_FIELD(project, id, REQUIRED),
+      BIND_FIELD(project, name, REQUIRED),
+      BIND_FIELD(project, identifier, REQUIRED),
+      BIND_FIELD(project, description, REQUIRED),
+      BIND_FIELD(project, homepage, OPTIONAL),
+      BIND_FIELD(project, parent, OPTIONAL),
+      BIND_FIELD(project, created_on, REQUIRED),
+      BIND_FIELD(project, updated_on, REQUIRED),
+  };
+  return fields;
 }
 
+json::object project::jsonify() const { return bind::write(*this); }
+
 bool project::operator==(const project &other) const { return id == other.id; }
 
 bool project::operator==(const char *str) const {
@@ -268,13 +249,15 @@ result project_new(redmine::cl::args &args, redmine::config &config,
     project.add("inherit_members", inherit_members);
   }
 
-  std::string data = json::write(json::object("project", project));
+  std::string data =
+      json::write(json::object("project", std::move(project)), json::compact);
 
   CHECK(options.debug, printf("%s\n", data.c_str()));
   std::string body;
   redmine::result error = http::post("/projects.json", config, options,
                                      http::code::CREATED, data, body);
-  json::value root = json::read(body, false);
+  json::value root =
+      timings::time("json::read", [&] { return json::read(body, false); });
   if (error) {
     CHECK_JSON_TYPE(root, json::TYPE_OBJECT);
     json::value *errors = root.object().get("errors");
@@ -335,12 +318,10 @@ result project_show(redmine::cl::args &args, redmine::config &config,
   // TODO: Lookup projects for name and get id
   std::string id(args[0]);
 
-  std::string body;
+  json::value root;
   CHECK_RETURN(http::get(std::string("/projects/") + id + ".json", config,
-                         options, body));
-
-  json::value root = json::read(body, false);
-  CHECK(options.debug, printf("%s\n", json::write(root, "  ").c_str()));
+                         options, root));
+  CHECK(options.debug, json::write(root, stdout, "  "); printf("\n"));
 
   auto &Project = root.object().get("project")->object();
   redmine::project project;
@@ -366,25 +347,27 @@ result project_show(redmine::cl::args &args, redmine::config &config,
 
 result query::projects(redmine::config &config, redmine::options &options,
                        std::vector<project> &projects) {
-  std::string body;
-  CHECK_RETURN(http::get("/projects.json?offset=0&limit=1000000", config,
-                         options, body));
-
-  auto root = json::read(body, false);
-  CHECK_JSON_TYPE(root, json::TYPE_OBJECT);
+  std::deque<json::tape> pages;
+  CHECK_RETURN(
+      http::get_pages("/projects.json", config, options, pages, http::CACHED));
+  for (auto &page : pages) {
+    auto &root = page.root();
+    CHECK_JSON_TYPE(root, json::TYPE_OBJECT);
 
-  CHECK(options.debug, printf("%s\n", json::write(root, "  ").c_str()));
+    CHECK(options.debug,
+          json::write(root.value(), stdout, "  "); printf("\n"));
 
-  auto Projects = root.object().get("projects");
-  CHECK_JSON_PTR(Projects, json::TYPE_ARRAY);
+    auto Projects = root.object().get("projects");
+    CHECK_JSON_PTR(Projects, json::TYPE_ARRAY);
 
-  for (auto Project : Projects->array()) {
-    CHECK_JSON_TYPE(Project, json::TYPE_OBJECT);
+    for (auto &Project : Projects->array()) {
+      CHECK_JSON_TYPE(Project, json::TYPE_OBJECT);
 
-    redmine::project project;
-    CHECK_RETURN(project.init(Project.object()));
+      redmine::project project;
+      CHECK_RETURN(project.init(Project.object()));
 
-    projects.push_back(project);
+      projects.push_back(project);
+    }
   }
 
   return SUCCESS;
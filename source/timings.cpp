@@ -0,0 +1,113 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <timings.h>
+
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace redmine {
+namespace timings {
+/// @brief Accumulated time of a section of client side work.
+struct section {
+  section() : count(0), seconds(0) {}
+
+  uint64_t count;
+  double seconds;
+};
+
+static bool active = false;
+static std::vector<request> requests;
+static std::map<std::string, section> sections;
+
+request::request()
+    : method(""),
+      path(),
+      status(0),
+      bytes(0),
+      dns(0),
+      connect(0),
+      tls(0),
+      ttfb(0),
+      total(0) {}
+
+void enable() { active = true; }
+
+bool enabled() { return active; }
+
+void record(const request &request) {
+  if (active) {
+    requests.push_back(request);
+  }
+}
+
+void record(const char *name, const double seconds) {
+  if (active) {
+    section &section = sections[name];
+    section.count++;
+    section.seconds += seconds;
+  }
+}
+
+scope::scope(const char *section) : section(section), start() {
+  if (active) {
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+scope::~scope() {
+  if (active) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    record(section, elapsed.count());
+  }
+}
+
+void print() {
+  fprintf(stderr,
+          "method | status |    bytes |    dns |  connect |    tls |   ttfb |"
+          "    total | path\n"
+          "-------|--------|----------|--------|----------|--------|--------|"
+          "----------|-----------------------------------\n");
+  double total = 0;
+  for (auto &request : requests) {
+    fprintf(stderr,
+            "%6s | %6u | %8llu | %6.1f | %8.1f | %6.1f | %6.1f | %8.1f | %s\n",
+            request.method, request.status,
+            static_cast<unsigned long long>(request.bytes),
+            request.dns * 1000, request.connect * 1000, request.tls * 1000,
+            request.ttfb * 1000, request.total * 1000, request.path.c_str());
+    total += request.total;
+  }
+  fprintf(stderr, "%zu requests in %.1f ms\n\n", requests.size(),
+          total * 1000);
+
+  fprintf(stderr,
+          "   calls |    total | section\n"
+          "---------|----------|-----------------------------------\n");
+  for (auto &section : sections) {
+    fprintf(stderr, "%8llu | %8.1f | %s\n",
+            static_cast<unsigned long long>(section.second.count),
+            section.second.seconds * 1000, section.first.c_str());
+  }
+}
+}  // timings
+}  // redmine
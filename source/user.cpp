@@ -18,62 +18,49 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <bind.h>
+#include <cache.h>
 #include <http.h>
+#include <timings.h>
 #include <user.h>
 
 #include <json/json.hpp>
 
+#include <algorithm>
 #include <cstring>
+#include <ctime>
 
 namespace redmine {
 user::user() {}
 
-result user::init(const json::object &object) {
-  auto Firstname = object.get("firstname");
-  CHECK_JSON_PTR(Firstname, json::TYPE_STRING);
-  firstname = Firstname->string();
-
-  auto Lastname = object.get("lastname");
-  CHECK_JSON_PTR(Lastname, json::TYPE_STRING);
-  lastname = Lastname->string();
-
+template <typename Object>
+result user::init(const Object &object) {
+  timings::scope timing("user::init");
+  CHECK_RETURN(bind::read(object, *this));
   name = firstname + " " + lastname;
-
-  auto Id = object.get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
-
-  auto Mail = object.get("mail");
-  CHECK_JSON_PTR(Mail, json::TYPE_STRING);
-  mail = Mail->string();
-
-  auto Login = object.get("login");
-  CHECK_JSON_PTR(Login, json::TYPE_STRING);
-  login = Login->string();
-
-  auto ApiKey = object.get("api_key");
-  if (ApiKey) {
-    CHECK_JSON_TYPE(*ApiKey, json::TYPE_STRING);
-    api_key = ApiKey->string();
-  }
-
-  auto CreatedOn = object.get("created_on");
-  CHECK_JSON_PTR(CreatedOn, json::TYPE_STRING);
-  created_on = CreatedOn->string();
-
-  auto LastLoginOn = object.get("last_login_on");
-  CHECK_JSON_PTR(LastLoginOn, json::TYPE_STRING);
-  last_login_on = LastLoginOn->string();
-
-  auto Status = object.get("status");
-  if (Status) {
-    CHECK_JSON_PTR(Status, json::TYPE_NUMBER);
-    status = Status->number<uint32_t>();
-  }
-
   return SUCCESS;
 }
 
+template result user::init(const json::object &object);
+template result user::init(const json::node &object);
+
+const std::vector<bind::field<user>> &user::fields() {
+  static const std::vector<bind::field<user>> fields = {
+      BIND_FIELD(user, id, REQUIRED),
+      BIND_FIELD(user, login, REQUIRED),
+      BIND_FIELD(user, firstname, REQUIRED),
+      BIND_FIELD(user, lastname, REQUIRED),
+      BIND_FIELD(user, mail, REQUIRED),
+      BIND_FIELD(user, created_on, REQUIRED),
+      BIND_FIELD(user, last_login_on, REQUIRED),
+      BIND_FIELD(user, api_key, OPTIONAL),
+      BIND_FIELD(user, status, OPTIONAL),
+  };
+  return fields;
+}
+
+json::object user::jsonify() const { return bind::write(*this); }
+
 current_user::current_user()
     : id(),
       login(),
@@ -87,216 +74,255 @@ current_user::current_user()
       project_permissions(),
       permissions() {}
 
-result current_user::get(redmine::config &config, redmine::options &options) {
-  std::string body;
-  CHECK_RETURN(http::get("/users/current.json?include=memberships,groups",
-                         config, options, body));
-
-  auto Root = json::read(body, false);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+/// @brief Name the cache entry holding the roles of a user, the fragment
+/// keeps it distinct from the responses of requests.
+static std::string roles_key(const redmine::config &config, uint32_t user) {
+  return config.current->url + "#roles/" + std::to_string(user);
+}
 
-  auto User = Root.object().get("user");
-  CHECK_JSON_PTR(User, json::TYPE_OBJECT);
+/// @brief Hash the projects of a set of memberships and the roles of each
+/// with FNV-1a, the permissions of projects are cached with this hash.
+static std::string memberships_hash(
+    const std::vector<current_user::membership> &memberships) {
+  std::vector<std::vector<uint32_t>> ids;
+  ids.reserve(memberships.size());
+  for (auto &membership : memberships) {
+    std::vector<uint32_t> membership_ids{membership.project.id};
+    for (auto &role : membership.roles) {
+      membership_ids.push_back(role.id);
+    }
+    std::sort(membership_ids.begin() + 1, membership_ids.end());
+    ids.push_back(std::move(membership_ids));
+  }
+  std::sort(ids.begin(), ids.end());
+  uint64_t hash = 14695981039346656037u;
+  for (auto &membership_ids : ids) {
+    // NOTE: Count the ids of each membership so sets hash differently.
+    hash = (hash ^ membership_ids.size()) * 1099511628211u;
+    for (uint32_t id : membership_ids) {
+      hash = (hash ^ id) * 1099511628211u;
+    }
+  }
+  char str[17];
+  snprintf(str, sizeof(str), "%016llx",
+           static_cast<unsigned long long>(hash));
+  return str;
+}
 
-  auto Id = User->object().get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
+/// @brief Read permissions stored by store_roles, indexed by their id.
+static void load_permissions(
+    const json::value *Permissions,
+    std::unordered_map<uint32_t, redmine::permissions> &out) {
+  if (!Permissions || json::TYPE_ARRAY != Permissions->type()) {
+    return;
+  }
+  for (auto &Permission : Permissions->array()) {
+    redmine::permissions permissions;
+    if (json::TYPE_OBJECT == Permission.type() &&
+        !permissions.init(Permission.object())) {
+      out[permissions.id] = permissions;
+    }
+  }
+}
 
-  auto Firstname = User->object().get("firstname");
-  CHECK_JSON_PTR(Firstname, json::TYPE_STRING);
-  firstname = Firstname->string();
+/// @brief Load the cached permissions of the roles of a user.
+///
+/// Nothing is loaded once the entry is older than
+/// redmine::config::profile::permissions_max_age, so every role is requested
+/// again. The permissions of each project are only loaded when the entry was
+/// stored for the same set of memberships.
+static void load_roles(
+    const redmine::config &config, uint32_t user, redmine::options &options,
+    const std::string &hash, cache::entry &entry,
+    std::unordered_map<uint32_t, redmine::permissions> &roles,
+    std::unordered_map<uint32_t, redmine::permissions> &projects) {
+  if (cache::load(config, roles_key(config, user), entry) ||
+      static_cast<uint64_t>(std::time(nullptr)) - entry.time >=
+          config.current->permissions_max_age) {
+    entry.time = 0;
+    return;
+  }
+  auto Root = json::read(entry.body, false);
+  if (json::TYPE_OBJECT != Root.type()) {
+    return;
+  }
+  load_permissions(Root.object().get("roles"), roles);
+  auto Memberships = Root.object().get("memberships");
+  if (Memberships && json::TYPE_STRING == Memberships->type() &&
+      hash == Memberships->string()) {
+    load_permissions(Root.object().get("projects"), projects);
+  }
+  CHECK(options.debug, printf("cache hit: %zu roles, %zu projects\n",
+                              roles.size(), projects.size()));
+}
 
-  auto Lastname = User->object().get("lastname");
-  CHECK_JSON_PTR(Lastname, json::TYPE_STRING);
-  lastname = Lastname->string();
+/// @brief Store the permissions of the roles of a user, roles no longer
+/// referenced by a membership are dropped.
+///
+/// The entry keeps the time it was first stored so newly requested roles do
+/// not extend the lifetime of the others. The permissions of each project are
+/// stored with the hash of the memberships they were resolved for, an empty
+/// hash when they are incomplete.
+static void store_roles(
+    const redmine::config &config, uint32_t user, const std::string &hash,
+    cache::entry &entry,
+    const std::unordered_map<uint32_t, redmine::permissions> &roles,
+    const std::unordered_map<uint32_t, redmine::permissions> &projects) {
+  json::array Roles;
+  Roles.reserve(roles.size());
+  for (auto &role : roles) {
+    Roles.append(role.second.jsonify());
+  }
+  json::array Projects;
+  Projects.reserve(projects.size());
+  for (auto &project : projects) {
+    Projects.append(project.second.jsonify());
+  }
+  if (!entry.time) {
+    entry.time = static_cast<uint64_t>(std::time(nullptr));
+  }
+  entry.body = json::write(json::object{{"memberships", hash},
+                                        {"roles", std::move(Roles)},
+                                        {"projects", std::move(Projects)}},
+                           json::compact);
+  cache::store(config, roles_key(config, user), entry);
+}
 
-  auto Mail = User->object().get("mail");
-  CHECK_JSON_PTR(Mail, json::TYPE_STRING);
-  mail = Mail->string();
+result current_user::get(redmine::config &config, redmine::options &options) {
+  json::value Root;
+  CHECK_RETURN(http::get("/users/current.json?include=memberships,groups",
+                         config, options, Root));
+  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+  CHECK(options.debug, json::write(Root, stdout, "  "); printf("\n"));
 
-  auto CreateOn = User->object().get("created_on");
-  CHECK_JSON_PTR(CreateOn, json::TYPE_STRING);
-  created_on = CreateOn->string();
+  auto User = Root.object().get("user");
+  CHECK_JSON_PTR(User, json::TYPE_OBJECT);
 
-  auto LastLoginOn = User->object().get("last_login_on");
-  CHECK_JSON_PTR(LastLoginOn, json::TYPE_STRING);
-  last_login_on = LastLoginOn->string();
+  return bind::read(User->object(), *this);
+}
 
-  auto Status = User->object().get("status");
-  if (Status) {
-    CHECK_JSON_TYPE(*Status, json::TYPE_NUMBER);
-    status = Status->number<uint32_t>();
+result current_user::resolve(
+    redmine::config &config, redmine::options &options,
+    const std::bitset<redmine::PERMISSION_COUNT> &checked) {
+  if (checked.none()) {
+    return SUCCESS;
+  }
+  const std::string hash = memberships_hash(memberships);
+  cache::entry entry;
+  std::unordered_map<uint32_t, redmine::permissions> cached;
+  std::unordered_map<uint32_t, redmine::permissions> projects;
+  load_roles(config, id, options, hash, entry, cached, projects);
+
+  // NOTE: The memberships are unchanged since the permissions of their
+  // projects were cached, use them as they are.
+  bool resolved = !projects.empty() || memberships.empty();
+  for (auto &membership : memberships) {
+    resolved = resolved && projects.count(membership.project.id);
+  }
+  if (resolved) {
+    for (auto &membership : memberships) {
+      project_permissions[membership.project.id] =
+          projects[membership.project.id];
+      permissions |= projects[membership.project.id];
+    }
+    return SUCCESS;
   }
 
-  auto Memberships = User->object().get("memberships");
-  CHECK_JSON_PTR(Memberships, json::TYPE_ARRAY);
-  for (auto &Membership : Memberships->array()) {
-    CHECK_JSON_TYPE(Membership, json::TYPE_OBJECT);
-
-    redmine::current_user::membership membership;
+  // NOTE: Roles are shared between memberships, use the cached permissions
+  // of each distinct role and request the rest once and all concurrently.
+  std::unordered_map<uint32_t, redmine::permissions> roles;
+  std::vector<uint32_t> missing;
+  std::bitset<redmine::PERMISSION_COUNT> granted;
+  for (auto &membership : memberships) {
+    for (auto &role : membership.roles) {
+      auto found = cached.find(role.id);
+      if (cached.end() != found) {
+        roles.insert({role.id, found->second});
+        granted |= found->second.granted;
+      } else if (missing.end() ==
+                 std::find(missing.begin(), missing.end(), role.id)) {
+        missing.push_back(role.id);
+      }
+    }
+  }
 
-    auto Project = Membership.object().get("project");
-    CHECK_JSON_PTR(Project, json::TYPE_OBJECT);
-    CHECK_RETURN(membership.project.init(Project->object()));
+  // NOTE: When the cached roles already grant every checked permission the
+  // other roles can not change the outcome of a check, skip requesting them.
+  // The roles entry is the cache of roles, request them without the response
+  // cache so both expire together.
+  std::vector<http::request> requests;
+  if ((granted & checked) != checked) {
+    for (uint32_t role : missing) {
+      requests.push_back(
+          {"/roles/" + std::to_string(role) + ".json", http::UNCACHED});
+    }
+  }
+  CHECK_RETURN(http::get(requests, config, options));
 
-    auto Roles = Membership.object().get("roles");
-    CHECK_JSON_PTR(Roles, json::TYPE_ARRAY);
-    for (auto &Role : Roles->array()) {
-      CHECK_JSON_TYPE(Role, json::TYPE_OBJECT);
+  for (auto &request : requests) {
+    auto Root = timings::time(
+        "json::read", [&] { return json::read(request.body, false); });
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+    CHECK(options.debug, json::write(Root, stdout, "  "); printf("\n"));
 
-      redmine::reference role;
-      CHECK_RETURN(role.init(Role.object()));
+    auto Role = Root.object().get("role");
+    CHECK_JSON_PTR(Role, json::TYPE_OBJECT);
 
-      membership.roles.push_back(role);
-    }
-
-    memberships.push_back(membership);
+    redmine::permissions role;
+    CHECK_RETURN(role.init(Role->object()));
+    roles[role.id] = role;
   }
 
+  projects.clear();
   for (auto &membership : memberships) {
-    redmine::permissions membership_permissions;
+    redmine::permissions &membership_permissions =
+        projects[membership.project.id];
+    membership_permissions.id = membership.project.id;
+    membership_permissions.name = membership.project.name;
     for (auto &role : membership.roles) {
-      redmine::permissions role_permissons;
-      CHECK_RETURN(role_permissons.get(role.id, config, options));
-      membership_permissions |= role_permissons;
-      permissions |= role_permissons;
+      auto found = roles.find(role.id);
+      if (roles.end() != found) {
+        membership_permissions |= found->second;
+      }
     }
     project_permissions[membership.project.id] = membership_permissions;
+    permissions |= membership_permissions;
+  }
+  const bool complete = requests.size() == missing.size();
+  if (!requests.empty() || roles.size() != cached.size() || complete) {
+    store_roles(config, id, complete ? hash : std::string(), entry, roles,
+                projects);
   }
 
   return SUCCESS;
 }
 
+const std::vector<bind::field<current_user>> &current_user::fields() {
+  static const std::vector<bind::field<current_user>> fields = {
+      BIND_FIELD(current_user, id, REQUIRED),
+      BIND_FIELD(current_user, login, OPTIONAL),
+      BIND_FIELD(current_user, firstname, REQUIRED),
+      BIND_FIELD(current_user, lastname, REQUIRED),
+      BIND_FIELD(current_user, mail, REQUIRED),
+      BIND_FIELD(current_user, created_on, REQUIRED),
+      BIND_FIELD(current_user, last_login_on, REQUIRED),
+      BIND_FIELD(current_user, status, OPTIONAL),
+      BIND_FIELD(current_user, memberships, REQUIRED),
+  };
+  return fields;
+}
+
+const std::vector<bind::field<current_user::membership>>
+    &current_user::membership::fields() {
+  static const std::vector<bind::field<membership>> fields = {
+      BIND_FIELD(membership, project, REQUIRED),
+      BIND_FIELD(membership, roles, REQUIRED),
+  };
+  return fields;
+}
+
 bool redmine::current_user::can(redmine::permisson permisson) {
-  switch (permisson) {
-    case ADD_PROJECT:
-      return permissions.add_project;
-    case EDIT_PROJECT:
-      return permissions.edit_project;
-    case CLOSE_PROJECT:
-      return permissions.close_project;
-    case SELECT_PROJECT_MODULES:
-      return permissions.select_project_modules;
-    case MANAGE_MEMBERS:
-      return permissions.manage_members;
-    case MANAGE_VERSIONS:
-      return permissions.manage_versions;
-    case ADD_SUBPROJECTS:
-      return permissions.add_subprojects;
-    case MANAGE_CATEGORIES:
-      return permissions.manage_categories;
-    case VIEW_ISSUES:
-      return permissions.view_issues;
-    case ADD_ISSUES:
-      return permissions.add_issues;
-    case EDIT_ISSUES:
-      return permissions.edit_issues;
-    case MANAGE_ISSUE_RELATIONS:
-      return permissions.manage_issue_relations;
-    case MANAGE_SUBTASKS:
-      return permissions.manage_subtasks;
-    case SET_ISSUES_PRIVATE:
-      return permissions.set_issues_private;
-    case SET_OWN_ISSUES_PRIVATE:
-      return permissions.set_own_issues_private;
-    case ADD_ISSUE_NOTES:
-      return permissions.add_issue_notes;
-    case EDIT_ISSUE_NOTES:
-      return permissions.edit_issue_notes;
-    case EDIT_OWN_ISSUE_NOTES:
-      return permissions.edit_own_issue_notes;
-    case VIEW_PRIVATE_NOTES:
-      return permissions.view_private_notes;
-    case SET_NOTES_PRIVATE:
-      return permissions.set_notes_private;
-    case MOVE_ISSUES:
-      return permissions.move_issues;
-    case DELETE_ISSUES:
-      return permissions.delete_issues;
-    case MANAGE_PUBLIC_QUERIES:
-      return permissions.manage_public_queries;
-    case SAVE_QUERIES:
-      return permissions.save_queries;
-    case VIEW_ISSUE_WATCHERS:
-      return permissions.view_issue_watchers;
-    case ADD_ISSUE_WATCHERS:
-      return permissions.add_issue_watchers;
-    case DELETE_ISSUE_WATCHERS:
-      return permissions.delete_issue_watchers;
-    case LOG_TIME:
-      return permissions.log_time;
-    case VIEW_TIME_ENTRIES:
-      return permissions.view_time_entries;
-    case EDIT_TIME_ENTRIES:
-      return permissions.edit_time_entries;
-    case EDIT_OWN_TIME_ENTRIES:
-      return permissions.edit_own_time_entries;
-    case MANAGE_PROJECT_ACTIVITIES:
-      return permissions.manage_project_activities;
-    case MANAGE_NEWS:
-      return permissions.manage_news;
-    case COMMENT_NEWS:
-      return permissions.comment_news;
-    case ADD_DOCUMENTS:
-      return permissions.add_documents;
-    case EDIT_DOCUMENTS:
-      return permissions.edit_documents;
-    case DELETE_DOCUMENTS:
-      return permissions.delete_documents;
-    case VIEW_DOCUMENTS:
-      return permissions.view_documents;
-    case MANAGE_FILES:
-      return permissions.manage_files;
-    case VIEW_FILES:
-      return permissions.view_files;
-    case MANAGE_WIKI:
-      return permissions.manage_wiki;
-    case RENAME_WIKI_PAGES:
-      return permissions.rename_wiki_pages;
-    case DELETE_WIKI_PAGES:
-      return permissions.delete_wiki_pages;
-    case VIEW_WIKI_PAGES:
-      return permissions.view_wiki_pages;
-    case EXPORT_WIKI_PAGES:
-      return permissions.export_wiki_pages;
-    case VIEW_WIKI_EDITS:
-      return permissions.view_wiki_edits;
-    case EDIT_WIKI_PAGES:
-      return permissions.edit_wiki_pages;
-    case DELETE_WIKI_PAGES_ATTACHMENTS:
-      return permissions.delete_wiki_pages_attachments;
-    case PROTECT_WIKI_PAGES:
-      return permissions.protect_wiki_pages;
-    case MANAGE_REPOSITORY:
-      return permissions.manage_repository;
-    case BROWSE_REPOSITORY:
-      return permissions.browse_repository;
-    case VIEW_CHANGESETS:
-      return permissions.view_changesets;
-    case COMMIT_ACCESS:
-      return permissions.commit_access;
-    case MANAGE_RELATED_ISSUES:
-      return permissions.manage_related_issues;
-    case MANAGE_BOARDS:
-      return permissions.manage_boards;
-    case ADD_MESSAGES:
-      return permissions.add_messages;
-    case EDIT_MESSAGES:
-      return permissions.edit_messages;
-    case EDIT_OWN_MESSAGES:
-      return permissions.edit_own_messages;
-    case DELETE_MESSAGES:
-      return permissions.delete_messages;
-    case DELETE_OWN_MESSAGES:
-      return permissions.delete_own_messages;
-    case VIEW_CALENDAR:
-      return permissions.view_calendar;
-    case VIEW_GANTT:
-      return permissions.view_gantt;
-    default:
-      return false;
-  }
+  return permissions.has(permisson);
 }
 
 namespace action {
@@ -348,13 +374,11 @@ result user_show(redmine::cl::args &args, redmine::config &config,
   CHECK(0 == args.count(), fprintf(stderr, "missing id\n"));
   CHECK(1 < args.count(), fprintf(stderr, "invalid argument: %s\n", args[1]));
 
-  std::string body;
+  json::value Root;
   CHECK_RETURN(http::get("/users/" + std::string(args[0]) + ".json", config,
-                         options, body));
-
-  auto Root = json::read(body, false);
+                         options, Root));
   CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
+  CHECK(options.debug, json::write(Root, stdout, "  "); printf("\n"));
 
   auto User = Root.object().get("user");
   CHECK_JSON_PTR(User, json::TYPE_OBJECT);
@@ -379,26 +403,24 @@ result user_show(redmine::cl::args &args, redmine::config &config,
 
 result query::users(redmine::config &config, redmine::options &options,
                     std::vector<user> &out) {
-  std::string body;
-  CHECK_RETURN(http::get("/users.json", config, options, body));
-
-  auto Root = json::read(body, false);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
-
-  auto Users = Root.object().get("users");
-  CHECK_JSON_PTR(Users, json::TYPE_ARRAY);
-
-  for (auto &User : Users->array()) {
-    CHECK_JSON_TYPE(User, json::TYPE_OBJECT);
-
-    redmine::user user;
-    CHECK_RETURN(user.init(User.object()));
-
-    out.push_back(user);
-  }
-
-  return SUCCESS;
+  auto read = [&](http::request &Page) -> result {
+    json::tape Tape;
+    CHECK(!json::read(std::move(Page.body), Tape, options.debug),
+          return FAILURE);
+    auto &Root = Tape.root();
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+
+    auto Users = Root.object().get("users");
+    CHECK_JSON_PTR(Users, json::TYPE_ARRAY);
+
+    for (auto &User : Users->array()) {
+      CHECK_JSON_TYPE(User, json::TYPE_OBJECT);
+      redmine::user user;
+      CHECK_RETURN(user.init(User.object()));
+      out.push_back(std::move(user));
+    }
+    return SUCCESS;
+  };
+  return http::get_pages("/users.json", config, options, read);
 }
 }  // redmine
@@ -20,9 +20,11 @@
 
 #include <util.h>
 
+#include <cerrno>
 #include <cstdio>
 
 #if defined(REDMINE_PLATFORM_LINUX) || defined(REDMINE_PLATFORM_MAC)
+#include <sys/stat.h>
 #include <unistd.h>
 #elif defined(REDMINE_PLATFORM_WINDOWS)
 #include <direct.h>
@@ -53,5 +55,24 @@ result rm(const std::string &filename) {
 #endif
   return SUCCESS;
 }
+
+result mkdir(const std::string &path) {
+  // NOTE: Create each missing parent directory in turn.
+  for (size_t index = path.find_first_of("/\\", 1); index != std::string::npos;
+       index = path.find_first_of("/\\", index + 1)) {
+    std::string parent = path.substr(0, index);
+#if defined(REDMINE_PLATFORM_LINUX) || defined(REDMINE_PLATFORM_MAC)
+    ::mkdir(parent.c_str(), 0700);
+#elif defined(REDMINE_PLATFORM_WINDOWS)
+    _mkdir(parent.c_str());
+#endif
+  }
+#if defined(REDMINE_PLATFORM_LINUX) || defined(REDMINE_PLATFORM_MAC)
+  CHECK(::mkdir(path.c_str(), 0700) && EEXIST != errno, return FAILURE);
+#elif defined(REDMINE_PLATFORM_WINDOWS)
+  CHECK(_mkdir(path.c_str()) && EEXIST != errno, return FAILURE);
+#endif
+  return SUCCESS;
+}
 }
 }
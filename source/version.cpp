@@ -18,7 +18,9 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <bind.h>
 #include <http.h>
+#include <timings.h>
 #include <version.h>
 
 #include <json/json.hpp>
@@ -34,65 +36,52 @@ version::version()
       updated_on(),
       project() {}
 
-result version::init(const json::object &object) {
-  auto Id = object.get("id");
-  CHECK_JSON_PTR(Id, json::TYPE_NUMBER);
-  id = Id->number<uint32_t>();
-
-  auto Name = object.get("name");
-  CHECK_JSON_PTR(Name, json::TYPE_STRING);
-  name = Name->string();
-
-  auto Description = object.get("description");
-  CHECK_JSON_PTR(Description, json::TYPE_STRING);
-  description = Description->string();
-
-  auto Status = object.get("status");
-  CHECK_JSON_PTR(Status, json::TYPE_STRING);
-  status = Status->string();
-
-  auto DueDate = object.get("due_date");
-  if (DueDate) {
-    CHECK_JSON_TYPE(*DueDate, json::TYPE_STRING);
-    due_date = DueDate->string();
-  }
-
-  auto CreateOn = object.get("created_on");
-  CHECK_JSON_PTR(CreateOn, json::TYPE_STRING);
-  created_on = CreateOn->string();
-
-  auto UpdatedOn = object.get("updated_on");
-  CHECK_JSON_PTR(UpdatedOn, json::TYPE_STRING);
-  updated_on = UpdatedOn->string();
-
-  auto Project = object.get("project");
-  CHECK_RETURN(project.init(Project->object()));
+template <typename Object>
+result version::init(const Object &object) {
+  timings::scope timing("version::init");
+  return bind::read(object, *this);
+}
 
-  return SUCCESS;
+template result version::init(const json::object &object);
+template result version::init(const json::node &object);
+
+const std::vector<bind::field<version>> &version::fields() {
+  static const std::vector<bind::field<version>> fields = {
+      BIND_FIELD(version, id, REQUIRED),
+      BIND_FIELD(version, project, REQUIRED),
+      BIND_FIELD(version, name, REQUIRED),
+      BIND_FIELD(version, description, REQUIRED),
+      BIND_FIELD(version, status, REQUIRED),
+      BIND_FIELD(version, due_date, OPTIONAL),
+      BIND_FIELD(version, created_on, REQUIRED),
+      BIND_FIELD(version, updated_on, REQUIRED),
+  };
+  return fields;
 }
 
 namespace query {
 result versions(const std::string &project, redmine::config &config,
                 redmine::options &options, std::vector<version> &versions) {
-  std::string body;
-  CHECK_RETURN(http::get(
-      "/projects/" + project + "/versions.json?offset=0&limit=1000000", config,
-      options, body));
-
-  auto Root = json::read(body, false);
-  CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
-  CHECK(options.debug, printf("%s\n", json::write(Root, "  ").c_str()));
-
-  auto Versions = Root.object().get("versions");
-  CHECK_JSON_PTR(Versions, json::TYPE_ARRAY);
-
-  for (auto &Version : Versions->array()) {
-    CHECK_JSON_TYPE(Version, json::TYPE_OBJECT);
-
-    redmine::version version;
-    CHECK_RETURN(version.init(Version.object()));
-
-    versions.push_back(version);
+  std::deque<json::tape> Pages;
+  CHECK_RETURN(http::get_pages("/projects/" + project + "/versions.json",
+                               config, options, Pages, http::CACHED));
+  for (auto &Page : Pages) {
+    auto &Root = Page.root();
+    CHECK_JSON_TYPE(Root, json::TYPE_OBJECT);
+    CHECK(options.debug,
+          json::write(Root.value(), stdout, "  "); printf("\n"));
+
+    auto Versions = Root.object().get("versions");
+    CHECK_JSON_PTR(Versions, json::TYPE_ARRAY);
+
+    for (auto &Version : Versions->array()) {
+      CHECK_JSON_TYPE(Version, json::TYPE_OBJECT);
+
+      redmine::version version;
+      CHECK_RETURN(version.init(Version.object()));
+
+      versions.push_back(version);
+    }
   }
 
   return SUCCESS;
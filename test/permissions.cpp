@@ -0,0 +1,133 @@
+// Copyright (C) 2015 Kenenth Benzie
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// NOTE: Requests are made to a port nothing listens on, so resolve fails if
+// it requests a role and succeeds only when the cached roles are enough.
+
+#include <cache.h>
+#include <config.h>
+#include <http.h>
+#include <redmine.h>
+#include <role.h>
+#include <user.h>
+
+#include <json/json.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+int failures = 0;
+
+void check(bool pass, const char *name, const std::string &detail) {
+  printf("%s: %s %s\n", pass ? "PASS" : "FAIL", name, detail.c_str());
+  if (!pass) {
+    failures++;
+  }
+}
+
+/// @brief Key of the roles cache entry of a user, as user.cpp names it.
+std::string roles_key(const redmine::config &config, uint32_t user) {
+  return config.current->url + "#roles/" + std::to_string(user);
+}
+
+/// @brief A user with two projects, only role 3 is cached and it grants
+/// adding issues.
+void setup(redmine::config &config, redmine::current_user &user) {
+  redmine::config::profile profile;
+  profile.name = "permissions_test";
+  profile.url = "http://127.0.0.1:1";
+  profile.permissions_max_age = 3600;
+  profile.retries = 0;
+  config.profiles.push_back(profile);
+  config.current = &config.profiles.back();
+
+  user.id = 7;
+  redmine::current_user::membership one;
+  one.project.id = 1;
+  one.project.name = "One";
+  one.roles.resize(2);
+  one.roles[0].id = 3;
+  one.roles[1].id = 4;
+  redmine::current_user::membership two;
+  two.project.id = 2;
+  two.project.name = "Two";
+  two.roles.resize(1);
+  two.roles[0].id = 4;
+  user.memberships = {one, two};
+
+  redmine::cache::entry entry;
+  entry.time = static_cast<uint64_t>(std::time(nullptr));
+  entry.body =
+      "{\"roles\": [{\"id\": 3, \"name\": \"Manager\", "
+      "\"permissions\": [\"add_issues\", \"view_issues\"]}]}";
+  redmine::cache::store(config, roles_key(config, user.id), entry);
+}
+
+/// @brief The cached role grants every checked permission so the other role
+/// is not requested and is left out of the stored roles.
+void test_skip() {
+  redmine::config config;
+  redmine::current_user user;
+  redmine::options options;
+  setup(config, user);
+
+  std::bitset<redmine::PERMISSION_COUNT> checked;
+  checked.set(redmine::ADD_ISSUES);
+  check(!user.resolve(config, options, checked), "skip",
+        "resolved without requests");
+  check(user.can(redmine::ADD_ISSUES) && user.can(redmine::VIEW_ISSUES),
+        "skip", "cached role granted");
+  check(user.project_permissions[1].has(redmine::ADD_ISSUES) &&
+            user.project_permissions[2].granted.none(),
+        "skip", "project permissions of the cached role only");
+
+  redmine::cache::entry entry;
+  check(!redmine::cache::load(config, roles_key(config, user.id), entry),
+        "skip", "roles stored");
+  json::value Root = json::read(entry.body, false);
+  const json::value *Roles =
+      json::TYPE_OBJECT == Root.type() ? Root.object().get("roles") : nullptr;
+  check(Roles && json::TYPE_ARRAY == Roles->type() &&
+            1 == Roles->array().size() &&
+            3 == Roles->array()[0].object().get("id")->number<int>(),
+        "skip", entry.body);
+
+  // NOTE: The skipped role is needed to check another permission, the
+  // project permissions stored by the skip path must not be used instead.
+  redmine::current_user again;
+  again.id = user.id;
+  again.memberships = user.memberships;
+  checked.set(redmine::EDIT_ISSUES);
+  check(again.resolve(config, options, checked), "incomplete",
+        "skipped role requested");
+}
+
+int main() {
+  setenv("XDG_CACHE_HOME", "permissions_test_cache", 1);
+  redmine::http::session http;
+  if (http.init()) {
+    fprintf(stderr, "http init failed\n");
+    return 1;
+  }
+  test_skip();
+  return failures ? 1 : 0;
+}